@@ -0,0 +1,210 @@
+/*Общий для задач по вычислительной геометрии вектор Vector<T, Dim> (Dim = 2 или 3),
+хранение массива векторов по координатам (structure of arrays) и параллельный цикл по частям диапазона.*/
+
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace geometry {
+
+template <class T, std::size_t Dim>
+struct Vector_storage;
+
+template <class T>
+struct Vector_storage<T, 2> {
+    constexpr T& operator[](std::size_t k) { return (k == 0 ? x : y); }
+    constexpr const T& operator[](std::size_t k) const { return (k == 0 ? x : y); }
+
+    T x = 0;
+    T y = 0;
+};
+
+template <class T>
+struct Vector_storage<T, 3> {
+    constexpr T& operator[](std::size_t k) { return (k == 0 ? x : (k == 1 ? y : z)); }
+    constexpr const T& operator[](std::size_t k) const { return (k == 0 ? x : (k == 1 ? y : z)); }
+
+    T x = 0;
+    T y = 0;
+    T z = 0;
+};
+
+template <class T, std::size_t Dim>
+struct Vector : Vector_storage<T, Dim> {
+    static_assert(std::is_floating_point<T>::value, "coordinates must be floating point");
+    static constexpr std::size_t dimension = Dim;
+
+    constexpr Vector() = default;
+
+    template <class... Coordinates, class = std::enable_if_t<sizeof...(Coordinates) == Dim &&
+            std::conjunction<std::is_arithmetic<Coordinates>...>::value>>
+    constexpr explicit Vector(Coordinates... coordinates) {
+        const T values[] = {static_cast<T>(coordinates)...};
+        for (std::size_t k = 0; k < Dim; ++k) (*this)[k] = values[k];
+    }
+
+    constexpr explicit Vector(const Vector& start, const Vector& end) {
+        for (std::size_t k = 0; k < Dim; ++k) (*this)[k] = end[k] - start[k];
+    }
+
+    constexpr T squared_length() const {
+        return scalar_product(*this, *this);
+    }
+
+    T length() const {
+        return std::sqrt(squared_length());
+    }
+
+    friend constexpr T scalar_product(const Vector& first, const Vector& second) {
+        T result = 0;
+        for (std::size_t k = 0; k < Dim; ++k) result += first[k] * second[k];
+        return result;
+    }
+
+    friend Vector proection(const Vector& base, const Vector& to_be_proected) {
+        return (scalar_product(base, to_be_proected) / base.squared_length()) * base;
+    }
+
+    constexpr Vector& operator+=(const Vector& other) {
+        for (std::size_t k = 0; k < Dim; ++k) (*this)[k] += other[k];
+        return *this;
+    }
+
+    constexpr Vector& operator-=(const Vector& other) {
+        for (std::size_t k = 0; k < Dim; ++k) (*this)[k] -= other[k];
+        return *this;
+    }
+
+    constexpr Vector& operator*=(T number) {
+        for (std::size_t k = 0; k < Dim; ++k) (*this)[k] *= number;
+        return *this;
+    }
+
+    friend constexpr Vector operator+(Vector first, const Vector& second) {
+        return first += second;
+    }
+
+    friend constexpr Vector operator-(Vector first, const Vector& second) {
+        return first -= second;
+    }
+
+    friend constexpr Vector operator-(Vector vect) {
+        return vect *= -1;
+    }
+
+    friend constexpr Vector operator*(T number, Vector vect) {
+        return vect *= number;
+    }
+
+    friend constexpr Vector operator*(Vector vect, T number) {
+        return vect *= number;
+    }
+
+    friend constexpr bool operator==(const Vector& first, const Vector& second) {
+        for (std::size_t k = 0; k < Dim; ++k) {
+            if (first[k] != second[k]) return false;
+        }
+        return true;
+    }
+
+    friend constexpr bool operator!=(const Vector& first, const Vector& second) {
+        return !(first == second);
+    }
+};
+
+//z-component of vector product of vectors on a plane
+template <class T>
+constexpr T vector_product(const Vector<T, 2>& first, const Vector<T, 2>& second) {
+    return first.x * second.y - second.x * first.y;
+}
+
+template <class T>
+constexpr Vector<T, 3> vector_product(const Vector<T, 3>& first, const Vector<T, 3>& second) {
+    return Vector<T, 3>(first.y * second.z - first.z * second.y,
+                        first.z * second.x - first.x * second.z,
+                        first.x * second.y - first.y * second.x);
+}
+
+template <class T, std::size_t Dim>
+T distance(const Vector<T, Dim>& first, const Vector<T, Dim>& second) {
+    return Vector<T, Dim>(first, second).length();
+}
+
+using Vector2f = Vector<float, 2>;
+using Vector3f = Vector<float, 3>;
+using Vector2d = Vector<double, 2>;
+using Vector3d = Vector<double, 3>;
+
+//array of vectors stored by coordinates: coordinate k of all vectors is contiguous in data(k)
+template <class T, std::size_t Dim>
+class Vector_array {
+public:
+    Vector_array() = default;
+    explicit Vector_array(std::size_t size) {
+        resize(size);
+    }
+
+    std::size_t size() const {
+        return coordinates[0].size();
+    }
+
+    void resize(std::size_t size) {
+        for (auto& coordinate : coordinates) coordinate.resize(size);
+    }
+
+    void reserve(std::size_t size) {
+        for (auto& coordinate : coordinates) coordinate.reserve(size);
+    }
+
+    void push_back(const Vector<T, Dim>& vect) {
+        for (std::size_t k = 0; k < Dim; ++k) coordinates[k].push_back(vect[k]);
+    }
+
+    Vector<T, Dim> operator[](std::size_t index) const {
+        Vector<T, Dim> result;
+        for (std::size_t k = 0; k < Dim; ++k) result[k] = coordinates[k][index];
+        return result;
+    }
+
+    void set(std::size_t index, const Vector<T, Dim>& vect) {
+        for (std::size_t k = 0; k < Dim; ++k) coordinates[k][index] = vect[k];
+    }
+
+    T* data(std::size_t k) {
+        return coordinates[k].data();
+    }
+
+    const T* data(std::size_t k) const {
+        return coordinates[k].data();
+    }
+
+private:
+    std::vector<T> coordinates[Dim];
+};
+
+//calls work(from, to) on parts of [0, count) in parallel threads if count is large enough
+template <class Function>
+void parallel_for(std::size_t count, std::size_t min_part, Function&& work) {
+    std::size_t threads_amount = std::max<std::size_t>(1, std::min<std::size_t>(std::thread::hardware_concurrency(),
+            count / std::max<std::size_t>(min_part, 1)));
+    if (threads_amount == 1) {
+        work(0, count);
+        return;
+    }
+    std::vector<std::thread> threads;
+    std::size_t part = (count + threads_amount - 1) / threads_amount;
+    for (std::size_t from = 0; from < count; from += part) {
+        threads.emplace_back(work, from, std::min(count, from + part));
+    }
+    for (auto& thread : threads) thread.join();
+}
+
+}
+
+#endif //GEOMETRY_H
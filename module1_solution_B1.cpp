@@ -2,55 +2,154 @@
 #include <iostream>
 #include <string>
 #include <vector>
-#include <bitset>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
 
-template <size_t T>
-size_t least_significant_bit(std::bitset<T>& set) {
-    for (size_t k = 1; k < T; ++k) {
-        if (set[k] != false){
-            return k;
-        }
-    }
-    return T;
-}
+constexpr size_t alphabet_size = 26;
+constexpr char first_letter = 'a';
+constexpr uint32_t alphabet_mask = (1u << alphabet_size) - 1;
 
-std::string restore_from_prefix_func(const std::vector<size_t>& pref_func) {
-    std::string answer;
-    constexpr size_t alphabet_size = 26;
-    constexpr char first_letter = 'a';
+//writes lexicographically minimal string with prefix function pref_func to answer, buffers are reused between calls;
+//returns false if pref_func is not a prefix function of any string in alphabet a-z
+bool restore_from_prefix_func(const uint32_t* pref_func, size_t length, std::string& answer,
+        std::vector<uint32_t>& check_buffer) {
+    answer.clear();
+    if (length == 0) return true;
+    if (pref_func[0] != 0) return false;
+    answer.reserve(length);
     answer += first_letter;
-    std::bitset<alphabet_size> alphabet;
-    alphabet.set();
-    for (size_t i = 1; i < pref_func.size(); ++i) {
+    for (size_t i = 1; i < length; ++i) {
+        if (pref_func[i] > pref_func[i - 1] + 1) return false;
         if (pref_func[i] != 0) {
-            answer += static_cast<char>(answer[pref_func[i] - 1]);
+            answer += answer[pref_func[i] - 1];
             continue;
         }
-        size_t prev_pref_func = pref_func[i - 1]; //значение префикс-функции для символа, стоящего перед
+        uint32_t prev_pref_func = pref_func[i - 1]; //значение префикс-функции для символа, стоящего перед
         // рассматриваемым
-        alphabet[0] = false; //при префик-функции равной 0 новый символ не 'a'
+        uint32_t forbidden = 1; //при префик-функции равной 0 новый символ не 'a'
 
         while (prev_pref_func != 0) {
             //проверяем, что не продлеваем  префикс меньшей длины
-            alphabet[answer[prev_pref_func] - first_letter] = false;
+            forbidden |= 1u << (answer[prev_pref_func] - first_letter);
             prev_pref_func = pref_func[prev_pref_func - 1];
         }
 
-        size_t left_letter = least_significant_bit(alphabet);
-        answer += static_cast<char>(left_letter + first_letter);
+        uint32_t free_letters = ~forbidden & alphabet_mask;
+        if (free_letters == 0) return false;
+        answer += static_cast<char>(__builtin_ctz(free_letters) + first_letter);
+    }
+
+    //restored string is consistent with pref_func iff its own prefix function is the same
+    check_buffer.assign(length, 0);
+    for (size_t i = 1; i < length; ++i) {
+        uint32_t k = check_buffer[i - 1];
+        while (k > 0 && answer[i] != answer[k]) k = check_buffer[k - 1];
+        if (answer[i] == answer[k]) ++k;
+        check_buffer[i] = k;
+        if (k != pref_func[i]) return false;
+    }
+    return true;
+}
+
+std::string read_all(std::FILE* input) {
+    std::string result;
+    char buffer[1 << 16];
+    size_t read;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), input)) > 0) {
+        result.append(buffer, read);
+    }
+    return result;
+}
 
-        alphabet.set();
+//parses unsigned numbers from [begin, end) to values; returns false if some token is not a number
+//or does not fit into uint32_t
+bool parse_numbers(const char* begin, const char* end, std::vector<uint32_t>& values) {
+    values.clear();
+    while (begin != end) {
+        if (*begin == ' ' || *begin == '\t' || *begin == '\r' || *begin == '\n') {
+            ++begin;
+            continue;
+        }
+        uint64_t value = 0;
+        const char* start = begin;
+        while (begin != end && *begin >= '0' && *begin <= '9') {
+            value = value * 10 + (*begin++ - '0');
+            if (value > UINT32_MAX) return false;
+        }
+        if (begin == start || (begin != end && *begin != ' ' && *begin != '\t' && *begin != '\r' && *begin != '\n'))
+            return false;
+        values.push_back(static_cast<uint32_t>(value));
     }
-    return answer;
+    return true;
 }
 
-int main() {
-    std::vector<size_t > input;
-    size_t c = 0;
-    while(std::cin >> c) {
-        input.push_back(c);
+//every line of input is one prefix function, answer for it is written in the same line,
+//"-" is written for impossible prefix functions; input is read by blocks, so only the current line is kept
+void restore_batch(std::FILE* input, std::FILE* output) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<uint32_t> pref_func;
+    std::vector<uint32_t> check_buffer;
+    std::string answer;
+    std::string result;
+    size_t arrays = 0;
+    size_t values = 0;
+    size_t rejected = 0;
+
+    auto restore_line = [&](const char* begin, const char* end) {
+        bool is_valid = parse_numbers(begin, end, pref_func)
+                && restore_from_prefix_func(pref_func.data(), pref_func.size(), answer, check_buffer);
+        result += (is_valid ? answer : "-");
+        result += '\n';
+        ++arrays;
+        values += pref_func.size();
+        rejected += !is_valid;
+
+        if (result.size() > (1 << 20)) {
+            std::fwrite(result.data(), 1, result.size(), output);
+            result.clear();
+        }
+    };
+
+    std::string pending; //lines read, the last of them may be incomplete
+    size_t searched = 0; //pending has no line breaks before this position
+    char block[1 << 16];
+    size_t read;
+    while ((read = std::fread(block, 1, sizeof(block), input)) > 0) {
+        pending.append(block, read);
+        size_t line_start = 0;
+        for (size_t line_end = pending.find('\n', searched); line_end != std::string::npos;
+                line_end = pending.find('\n', line_start)) {
+            restore_line(pending.data() + line_start, pending.data() + line_end);
+            line_start = line_end + 1;
+        }
+        pending.erase(0, line_start);
+        searched = pending.size();
+    }
+    if (!pending.empty()) restore_line(pending.data(), pending.data() + pending.size());
+    std::fwrite(result.data(), 1, result.size(), output);
+
+    std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+    std::fprintf(stderr, "%zu arrays (%zu rejected), %zu values in %.3f s: %.0f arrays/s, %.0f values/s\n",
+                 arrays, rejected, values, seconds.count(), arrays / seconds.count(), values / seconds.count());
+}
+
+//usage: module1_solution_B1 [--batch]
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--batch") {
+        restore_batch(stdin, stdout);
+        return 0;
+    }
+
+    std::string text = read_all(stdin);
+    std::vector<uint32_t> input;
+    std::string answer;
+    std::vector<uint32_t> check_buffer;
+    if (!parse_numbers(text.data(), text.data() + text.length(), input) ||
+        !restore_from_prefix_func(input.data(), input.size(), answer, check_buffer)) {
+        std::cerr << "input is not a prefix function\n";
+        return 1;
     }
-    std::string answer = restore_from_prefix_func(input);
     std::cout << answer;
     return 0;
 }
@@ -3,142 +3,874 @@
 
 #include <iostream>
 #include <cmath>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <array>
+#include <limits>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#include "geometry.h"
 
-double abs(double x) {
-    return (x > 0 ? x : -x);
+using Vector = geometry::Vector<double, 3>;
+
+struct Segment {
+    explicit Segment(const Vector& _start, const Vector& _end) : start(_start), direction(_end - _start), end(_end) {}
+    double length() const { return direction.length(); }
+    Vector point(double t) const { return start + t * direction; } //t in [0, 1]
+
+    Vector start;
+    Vector direction;
+    Vector end;
+};
+
+enum class Minimization_method {
+    ternary, //two new evaluations per iteration, interval shrinks to 2/3
+    golden_section, //one new evaluation per iteration, interval shrinks to 0.618
+    brent //parabolic interpolation with golden section steps as fallback
+};
+
+struct Minimization_options {
+    Minimization_method method = Minimization_method::golden_section;
+    double epsilon = 1e-8; //final length of interval of argument
+    size_t iterations = 0; //if not 0, exactly so many iterations are done and epsilon is ignored
+};
+
+struct Minimum {
+    double argument;
+    double value;
+    size_t evaluations;
+};
+
+//minimum of function unimodal on [left, right], function is any callable double(double)
+template <class Function>
+Minimum minimize_unimodal(Function&& function, double left, double right,
+        const Minimization_options& options = Minimization_options()) {
+    const double golden = 0.3819660112501051; //(3 - sqrt(5)) / 2
+    auto should_stop = [&](size_t iteration, double length) {
+        return (options.iterations > 0 ? iteration >= options.iterations : length <= options.epsilon);
+    };
+    size_t iteration = 0;
+
+    if (options.method == Minimization_method::ternary) {
+        double first_value = 0;
+        double second_value = 0;
+        for (; !should_stop(iteration, right - left); ++iteration) {
+            double first = left + (right - left) / 3;
+            double second = right - (right - left) / 3;
+            first_value = function(first);
+            second_value = function(second);
+            if (first_value > second_value) left = first;
+            else right = second;
+        }
+        double argument = 0.5 * (left + right);
+        return {argument, function(argument), 2 * iteration + 1};
+    }
+
+    if (options.method == Minimization_method::golden_section) {
+        double first = left + golden * (right - left);
+        double second = right - golden * (right - left);
+        double first_value = function(first);
+        double second_value = function(second);
+        for (; !should_stop(iteration, right - left); ++iteration) {
+            if (first_value > second_value) { //inner dot becomes outer one of smaller interval
+                left = first;
+                first = second;
+                first_value = second_value;
+                second = right - golden * (right - left);
+                second_value = function(second);
+            }
+            else {
+                right = second;
+                second = first;
+                second_value = first_value;
+                first = left + golden * (right - left);
+                first_value = function(first);
+            }
+        }
+        return (first_value < second_value ? Minimum{first, first_value, iteration + 2}
+                                           : Minimum{second, second_value, iteration + 2});
+    }
+
+    //brent: x is the best dot, w is the second best, v is the previous w, u is the last evaluated
+    const double tolerance = 0.25 * options.epsilon;
+    double x = left + golden * (right - left);
+    double w = x;
+    double v = x;
+    double x_value = function(x);
+    double w_value = x_value;
+    double v_value = x_value;
+    double step = 0; //last step
+    double previous_step = 0; //step before last
+    size_t evaluations = 1;
+    for (;; ++iteration) {
+        double middle = 0.5 * (left + right);
+        if (options.iterations > 0 ? iteration >= options.iterations
+                                   : std::abs(x - middle) <= 2 * tolerance - 0.5 * (right - left))
+            break;
+
+        bool is_parabolic = false;
+        if (std::abs(previous_step) > tolerance) { //parabola through x, w, v
+            double r = (x - w) * (x_value - v_value);
+            double q = (x - v) * (x_value - w_value);
+            double p = (x - v) * q - (x - w) * r;
+            q = 2 * (q - r);
+            if (q > 0) p = -p;
+            q = std::abs(q);
+            //parabolic step is taken if it is inside interval and smaller than half of the step before last
+            if (std::abs(p) < std::abs(0.5 * q * previous_step) && p > q * (left - x) && p < q * (right - x)) {
+                previous_step = step;
+                step = p / q;
+                double u = x + step;
+                if (u - left < 2 * tolerance || right - u < 2 * tolerance)
+                    step = (middle > x ? tolerance : -tolerance);
+                is_parabolic = true;
+            }
+        }
+        if (!is_parabolic) { //golden section step into the larger part
+            previous_step = (x >= middle ? left - x : right - x);
+            step = golden * previous_step;
+        }
+
+        double u = (std::abs(step) >= tolerance ? x + step : x + (step > 0 ? tolerance : -tolerance));
+        double u_value = function(u);
+        ++evaluations;
+        if (u_value <= x_value) {
+            if (u >= x) left = x;
+            else right = x;
+            v = w;
+            v_value = w_value;
+            w = x;
+            w_value = x_value;
+            x = u;
+            x_value = u_value;
+        }
+        else {
+            if (u < x) left = u;
+            else right = u;
+            if (u_value <= w_value || w == x) {
+                v = w;
+                v_value = w_value;
+                w = u;
+                w_value = u_value;
+            }
+            else if (u_value <= v_value || v == x || v == w) {
+                v = u;
+                v_value = u_value;
+            }
+        }
+    }
+    return {x, x_value, evaluations};
+}
+
+//Set_of_Objects must have functions point(t), t in [0, 1], and length(), distance(dot, point(t)) must be unimodal;
+//epsilon of options is measured in length of set, distance is any callable double(const Object&, const Object&);
+//returns minimal distance and the closest Object of set
+template<class Object, class Set_of_Objects, class Distance>
+std::pair<double, Object> ternary_search(const Object& dot, const Set_of_Objects& set, Distance&& distance,
+        Minimization_options options = Minimization_options(), size_t* evaluations = nullptr) {
+    if (options.iterations == 0) options.epsilon /= std::max(set.length(), options.epsilon);
+    Minimum minimum = minimize_unimodal([&](double t) { return distance(dot, set.point(t)); }, 0, 1, options);
+    if (evaluations) *evaluations += minimum.evaluations;
+    return std::make_pair(minimum.value, set.point(minimum.argument));
 }
 
-struct Vector {
-    Vector() = default;
-    explicit Vector(double _x, double _y, double _z) :  x(_x), y(_y), z(_z) {}
-    explicit Vector(const Vector& start, const Vector& end) {
-        x = end.x - start.x;
-        y = end.y - start.y;
-        z = end.z - start.z;
+//distance to the second segment is unimodal along the first one, it is minimized by nested search
+double find_distance_between_segments_by_ternary_search(const Segment& first, const Segment& second,
+        Minimization_options options = Minimization_options(), size_t* evaluations = nullptr) {
+    Minimization_options inner_options(options);
+    if (options.iterations == 0) options.epsilon /= std::max(first.length(), options.epsilon);
+    Minimum minimum = minimize_unimodal([&](double s) {
+        return ternary_search(first.point(s), second, [](const Vector& a, const Vector& b) { return distance(a, b); },
+                              inner_options, evaluations).first;
+    }, 0, 1, options);
+    return minimum.value;
+}
+
+struct Closest_points {
+    double distance;
+    Vector on_first;
+    Vector on_second;
+};
+
+double clamp_to_segment(double parameter) {
+    return (parameter < 0 ? 0 : (parameter > 1 ? 1 : parameter));
+}
+
+//parameters s, t of closest points first.start + s * first.direction and second.start + t * second.direction,
+//r = first.start - second.start; they are found from minimization of squared distance over (s, t) in [0, 1]^2:
+//unconstrained minimum is clamped to the first segment, then t is found for it and, if t is clamped,
+//s is found again for that t
+std::pair<double, double> find_closest_parameters(const Vector& first_direction, const Vector& second_direction,
+        const Vector& r) {
+    const double parallel_epsilon = 1e-12; //squared sine of angle between segments, which are treated as parallel
+    double a = scalar_product(first_direction, first_direction);
+    double e = scalar_product(second_direction, second_direction);
+    double f = scalar_product(second_direction, r);
+    double s = 0;
+    double t = 0;
+
+    if (a == 0 && e == 0) { //both segments are dots
+    }
+    else if (a == 0) {
+        t = clamp_to_segment(f / e);
     }
+    else {
+        double c = scalar_product(first_direction, r);
+        if (e == 0) {
+            s = clamp_to_segment(-c / a);
+        }
+        else {
+            double b = scalar_product(first_direction, second_direction);
+            double denominator = a * e - b * b;
+            if (denominator > parallel_epsilon * a * e) { //for parallel segments any s fits, s = 0 is taken
+                s = clamp_to_segment((b * f - c * e) / denominator);
+            }
+            t = (b * s + f) / e;
+            if (t < 0) {
+                t = 0;
+                s = clamp_to_segment(-c / a);
+            }
+            else if (t > 1) {
+                t = 1;
+                s = clamp_to_segment((b - c) / a);
+            }
+        }
+    }
+    return std::make_pair(s, t);
+}
+
+Closest_points find_closest_points_between_segments(const Segment& first, const Segment& second) {
+    std::pair<double, double> parameters = find_closest_parameters(first.direction, second.direction,
+                                                                   Vector(second.start, first.start));
+    Closest_points result;
+    result.on_first = first.start + parameters.first * first.direction;
+    result.on_second = second.start + parameters.second * second.direction;
+    result.distance = distance(result.on_first, result.on_second);
+    return result;
+}
 
-    double length() const {
-        return sqrt(x*x + y*y + z*z);
+double find_distance_between_segments(const Segment& first, const Segment& second) {
+    return find_closest_points_between_segments(first, second).distance;
+}
+
+//segments in structure of arrays layout, coordinate k of starts is start.data(k), of directions -- direction.data(k)
+struct Segment_batch {
+    void add(const Segment& segment) {
+        start.push_back(segment.start);
+        direction.push_back(segment.direction);
     }
 
-    friend double scalar_product(const Vector& first, const Vector& second) {
-        return first.x * second.x + first.y * second.y + first.z * second.z;
+    size_t size() const { return start.size(); }
+
+    geometry::Vector_array<double, 3> start;
+    geometry::Vector_array<double, 3> direction;
+};
+
+//lanes of one pack of pairs; same kernel is instantiated for double and for vector registers
+namespace lanes {
+    inline double broadcast(double value, double) { return value; }
+    inline double load(const double* source, double) { return *source; }
+    inline double gather(const double* source, const uint32_t* index, double) { return source[*index]; }
+    inline void store(double* destination, double value) { *destination = value; }
+    inline double select(bool mask, double if_true, double if_false) { return mask ? if_true : if_false; }
+    inline double clamp(double value) { return std::min(std::max(value, 0.), 1.); }
+    inline double square_root(double value) { return std::sqrt(value); }
+
+#if defined(__AVX2__)
+    struct Pack4 { __m256d value; };
+    inline Pack4 operator+(Pack4 a, Pack4 b) { return {_mm256_add_pd(a.value, b.value)}; }
+    inline Pack4 operator-(Pack4 a, Pack4 b) { return {_mm256_sub_pd(a.value, b.value)}; }
+    inline Pack4 operator*(Pack4 a, Pack4 b) { return {_mm256_mul_pd(a.value, b.value)}; }
+    inline Pack4 operator/(Pack4 a, Pack4 b) { return {_mm256_div_pd(a.value, b.value)}; }
+    inline Pack4 operator-(Pack4 a) { return {_mm256_sub_pd(_mm256_setzero_pd(), a.value)}; }
+    inline Pack4 operator<(Pack4 a, Pack4 b) { return {_mm256_cmp_pd(a.value, b.value, _CMP_LT_OQ)}; }
+    inline Pack4 operator>(Pack4 a, Pack4 b) { return {_mm256_cmp_pd(a.value, b.value, _CMP_GT_OQ)}; }
+    inline Pack4 broadcast(double value, Pack4) { return {_mm256_set1_pd(value)}; }
+    inline Pack4 load(const double* source, Pack4) { return {_mm256_loadu_pd(source)}; }
+    inline Pack4 gather(const double* source, const uint32_t* index, Pack4) { //masked form has a defined source
+        __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+        return {_mm256_mask_i32gather_pd(_mm256_setzero_pd(), source,
+                                         _mm_loadu_si128(reinterpret_cast<const __m128i*>(index)), all, 8)};
+    }
+    inline void store(double* destination, Pack4 value) { _mm256_storeu_pd(destination, value.value); }
+    inline Pack4 select(Pack4 mask, Pack4 if_true, Pack4 if_false) {
+        return {_mm256_blendv_pd(if_false.value, if_true.value, mask.value)};
     }
+    inline Pack4 clamp(Pack4 value) {
+        return {_mm256_min_pd(_mm256_max_pd(value.value, _mm256_setzero_pd()), _mm256_set1_pd(1.))};
+    }
+    inline Pack4 square_root(Pack4 value) { return {_mm256_sqrt_pd(value.value)}; }
+#endif
 
-    friend Vector proection(const Vector& base, const Vector& to_be_proected) {
-        Vector result;
-        double coef = scalar_product(base, to_be_proected) / base.length();
-        result.x = base.x / abs(base.x) * coef;
-        result.y = base.y / abs(base.y) * coef;
-        result.z = base.z / abs(base.z) * coef;
-        return result;
+#if defined(__AVX512F__)
+    struct Mask8 { __mmask8 value; };
+    struct Pack8 { __m512d value; };
+    inline Pack8 operator+(Pack8 a, Pack8 b) { return {_mm512_add_pd(a.value, b.value)}; }
+    inline Pack8 operator-(Pack8 a, Pack8 b) { return {_mm512_sub_pd(a.value, b.value)}; }
+    inline Pack8 operator*(Pack8 a, Pack8 b) { return {_mm512_mul_pd(a.value, b.value)}; }
+    inline Pack8 operator/(Pack8 a, Pack8 b) { return {_mm512_div_pd(a.value, b.value)}; }
+    inline Pack8 operator-(Pack8 a) { return {_mm512_sub_pd(_mm512_setzero_pd(), a.value)}; }
+    inline Mask8 operator<(Pack8 a, Pack8 b) { return {_mm512_cmp_pd_mask(a.value, b.value, _CMP_LT_OQ)}; }
+    inline Mask8 operator>(Pack8 a, Pack8 b) { return {_mm512_cmp_pd_mask(a.value, b.value, _CMP_GT_OQ)}; }
+    inline Pack8 broadcast(double value, Pack8) { return {_mm512_set1_pd(value)}; }
+    inline Pack8 load(const double* source, Pack8) { return {_mm512_loadu_pd(source)}; }
+    inline Pack8 gather(const double* source, const uint32_t* index, Pack8) {
+        return {_mm512_i32gather_pd(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(index)), source, 8)};
     }
+    inline void store(double* destination, Pack8 value) { _mm512_storeu_pd(destination, value.value); }
+    inline Pack8 select(Mask8 mask, Pack8 if_true, Pack8 if_false) {
+        return {_mm512_mask_blend_pd(mask.value, if_false.value, if_true.value)};
+    }
+    inline Pack8 clamp(Pack8 value) {
+        return {_mm512_min_pd(_mm512_max_pd(value.value, _mm512_setzero_pd()), _mm512_set1_pd(1.))};
+    }
+    inline Pack8 square_root(Pack8 value) { return {_mm512_sqrt_pd(value.value)}; }
+#endif
+}
 
-    friend Vector operator+(const Vector& first, const Vector& second) {
-        Vector result;
-        result.x = first.x + second.x;
-        result.y = first.y + second.y;
-        result.z = first.z + second.z;
-        return result;
+#if defined(__AVX512F__)
+using Widest_pack = lanes::Pack8;
+constexpr size_t widest_pack_size = 8;
+#elif defined(__AVX2__)
+using Widest_pack = lanes::Pack4;
+constexpr size_t widest_pack_size = 4;
+#else
+using Widest_pack = double;
+constexpr size_t widest_pack_size = 1;
+#endif
+
+//same minimization as in find_closest_points_between_segments without branches: divisions by zero lengths are
+//replaced with zero and every case is computed and selected, so lanes of one pack may fall into different cases;
+//coordinates are start x, y, z and direction x, y, z
+template <class Pack>
+Pack segment_distance_kernel(const Pack (&first)[6], const Pack (&second)[6]) {
+    using namespace lanes;
+    const Pack zero = broadcast(0., Pack());
+    const Pack one = broadcast(1., Pack());
+    const Pack parallel_epsilon = broadcast(1e-12, Pack());
+
+    Pack r[3];
+    for (size_t k = 0; k < 3; ++k) r[k] = first[k] - second[k];
+    Pack a = first[3] * first[3] + first[4] * first[4] + first[5] * first[5];
+    Pack e = second[3] * second[3] + second[4] * second[4] + second[5] * second[5];
+    Pack b = first[3] * second[3] + first[4] * second[4] + first[5] * second[5];
+    Pack c = first[3] * r[0] + first[4] * r[1] + first[5] * r[2];
+    Pack f = second[3] * r[0] + second[4] * r[1] + second[5] * r[2];
+    Pack inverse_a = select(a > zero, one / a, zero);
+    Pack inverse_e = select(e > zero, one / e, zero);
+    Pack denominator = a * e - b * b;
+
+    Pack s = select(denominator > parallel_epsilon * a * e, clamp((b * f - c * e) / denominator),
+                    clamp(-c * inverse_a)); //for parallel segments point closest to second.start is taken
+    Pack t = (b * s + f) * inverse_e;
+    s = select(t < zero, clamp(-c * inverse_a), select(t > one, clamp((b - c) * inverse_a), s));
+    t = clamp(t);
+
+    Pack squared = zero;
+    for (size_t k = 0; k < 3; ++k) {
+        Pack difference = r[k] + s * first[k + 3] - t * second[k + 3];
+        squared = squared + difference * difference;
     }
+    return square_root(squared);
+}
 
-    friend Vector operator-(const Vector& first, const Vector& second) {
-        Vector result;
-        result.x = first.x - second.x;
-        result.y = first.y - second.y;
-        result.z = first.z - second.z;
-        return result;
+//single lane takes branches, it is cheaper than computing every case
+template <>
+double segment_distance_kernel<double>(const double (&first)[6], const double (&second)[6]) {
+    Vector first_direction(first[3], first[4], first[5]);
+    Vector second_direction(second[3], second[4], second[5]);
+    Vector r(first[0] - second[0], first[1] - second[1], first[2] - second[2]);
+    std::pair<double, double> parameters = find_closest_parameters(first_direction, second_direction, r);
+    return (r + parameters.first * first_direction - parameters.second * second_direction).length();
+}
+
+const double* segment_coordinate(const Segment_batch& batch, size_t k) {
+    return (k < 3 ? batch.start.data(k) : batch.direction.data(k - 3));
+}
+
+//distances between first[first_indices[i]] and second[second_indices[i]] for i in [from, to)
+template <class Pack>
+size_t find_listed_distances(const Segment_batch& first, const Segment_batch& second, const uint32_t* first_indices,
+        const uint32_t* second_indices, size_t from, size_t to, size_t pack_size, double* result) {
+    const double* first_coordinates[6];
+    const double* second_coordinates[6];
+    for (size_t k = 0; k < 6; ++k) {
+        first_coordinates[k] = segment_coordinate(first, k);
+        second_coordinates[k] = segment_coordinate(second, k);
+    }
+    Pack first_pack[6];
+    Pack second_pack[6];
+    for (; from + pack_size <= to; from += pack_size) {
+        for (size_t k = 0; k < 6; ++k) {
+            first_pack[k] = lanes::gather(first_coordinates[k], first_indices + from, Pack());
+            second_pack[k] = lanes::gather(second_coordinates[k], second_indices + from, Pack());
+        }
+        lanes::store(result + from, segment_distance_kernel(first_pack, second_pack));
+    }
+    return from;
+}
+
+//distances between first[row] and second[j] for j in [from, to)
+template <class Pack>
+size_t find_row_distances(const Segment_batch& first, const Segment_batch& second, size_t row,
+        size_t from, size_t to, size_t pack_size, double* result) {
+    const double* second_coordinates[6];
+    Pack first_pack[6];
+    Pack second_pack[6];
+    for (size_t k = 0; k < 6; ++k) {
+        first_pack[k] = lanes::broadcast(segment_coordinate(first, k)[row], Pack());
+        second_coordinates[k] = segment_coordinate(second, k);
+    }
+    for (; from + pack_size <= to; from += pack_size) {
+        for (size_t k = 0; k < 6; ++k) {
+            second_pack[k] = lanes::load(second_coordinates[k] + from, Pack());
+        }
+        lanes::store(result + from, segment_distance_kernel(first_pack, second_pack));
     }
+    return from;
+}
+
+constexpr size_t min_pairs_per_thread = 1 << 15;
+
+//result[i] is distance between first[first_indices[i]] and second[second_indices[i]]
+void find_distances_between_segments(const Segment_batch& first, const Segment_batch& second,
+        const std::vector<uint32_t>& first_indices, const std::vector<uint32_t>& second_indices,
+        std::vector<double>& result) {
+    result.resize(first_indices.size());
+    geometry::parallel_for(first_indices.size(), min_pairs_per_thread, [&](size_t from, size_t to) {
+        from = find_listed_distances<Widest_pack>(first, second, first_indices.data(), second_indices.data(),
+                                                  from, to, widest_pack_size, result.data());
+        find_listed_distances<double>(first, second, first_indices.data(), second_indices.data(),
+                                      from, to, 1, result.data());
+    });
+}
 
-    friend Vector operator*(double number, const Vector& vect) {
-        Vector result(vect);
-        result.x  *= number;
-        result.y  *= number;
-        result.z  *= number;
+//result[i * second.size() + j] is distance between first[i] and second[j]
+void find_distances_between_segments(const Segment_batch& first, const Segment_batch& second,
+        std::vector<double>& result) {
+    const size_t columns = second.size();
+    result.resize(first.size() * columns);
+    const size_t min_rows_per_thread = min_pairs_per_thread / std::max<size_t>(columns, 1) + 1;
+    geometry::parallel_for(first.size(), min_rows_per_thread, [&](size_t from, size_t to) {
+        for (size_t row = from; row < to; ++row) {
+            double* row_result = result.data() + row * columns;
+            size_t j = find_row_distances<Widest_pack>(first, second, row, 0, columns, widest_pack_size, row_result);
+            find_row_distances<double>(first, second, row, j, columns, 1, row_result);
+        }
+    });
+}
+
+//axis aligned bounding box
+struct Box {
+    Box() {
+        min.fill(std::numeric_limits<double>::infinity());
+        max.fill(-std::numeric_limits<double>::infinity());
+    }
+    explicit Box(const Segment& segment) : Box() {
+        add(segment.start);
+        add(segment.end);
+    }
+
+    void add(const Vector& dot) {
+        for (size_t k = 0; k < 3; ++k) {
+            min[k] = std::min(min[k], dot[k]);
+            max[k] = std::max(max[k], dot[k]);
+        }
+    }
+
+    void add(const Box& box) {
+        for (size_t k = 0; k < 3; ++k) {
+            min[k] = std::min(min[k], box.min[k]);
+            max[k] = std::max(max[k], box.max[k]);
+        }
+    }
+
+    double half_area() const {
+        if (min[0] > max[0]) return 0;
+        double dx = max[0] - min[0];
+        double dy = max[1] - min[1];
+        double dz = max[2] - min[2];
+        return dx * dy + dy * dz + dz * dx;
+    }
+
+    //lower bound of distance between any objects inside boxes, squared
+    friend double squared_distance(const Box& first, const Box& second) {
+        double result = 0;
+        for (size_t k = 0; k < 3; ++k) {
+            double gap = std::max({0., first.min[k] - second.max[k], second.min[k] - first.max[k]});
+            result += gap * gap;
+        }
         return result;
     }
 
-    double x;
-    double y;
-    double z;
+    std::array<double, 3> min;
+    std::array<double, 3> max;
 };
 
-double distance(const Vector& first, const Vector& second) {
-    double result = sqrt((first.x - second.x) * (first.x - second.x)
-                         + (first.y - second.y) * (first.y - second.y)
-                         + (first.z - second.z) * (first.z - second.z));
-    return result;
-}
+//bounding volume hierarchy over segments built by binned surface area heuristic, nodes are kept in one array
+//in depth first order: left child of node v is v + 1, segment distance is used only for segments in leaves;
+//segments are not copied and must outlive the hierarchy
+class Segment_bvh {
+public:
+    explicit Segment_bvh(const std::vector<Segment>& _segments);
 
-struct Segment {
-    explicit Segment(const Vector& _start, const Vector& _end) : start(_start), direction(_end - _start), end(_end) {}
-    double length() { return direction.length(); }
-    std::pair<Vector, Vector> split_on_three_parts() const;
+    //index of segment closest to query and closest points
+    std::pair<uint32_t, Closest_points> find_nearest(const Segment& query) const;
+    //(distance, index) of k segments closest to query in order of distance
+    std::vector<std::pair<double, uint32_t>> find_k_nearest(const Segment& query, size_t k) const;
+    //all pairs (i, j), i < j, of segments with distance not greater than radius
+    std::vector<std::pair<uint32_t, uint32_t>> find_pairs_within_radius(double radius) const;
 
-    Vector start;
-    Vector direction;
-    Vector end;
+private:
+    static constexpr size_t bins_amount = 16;
+    static constexpr uint32_t max_leaf_size = 4;
+
+    struct Node {
+        Box box;
+        uint32_t first; //first segment in order for leaf, right child for inner node
+        uint32_t count; //amount of segments for leaf, 0 for inner node
+    };
+
+    const std::vector<Segment>& segments;
+    std::vector<Box> boxes;
+    std::vector<uint32_t> order; //segments of leaf v are order[first, first + count)
+    std::vector<Node> nodes;
+
+    void build(uint32_t from, uint32_t to);
+    void collect_pairs(uint32_t first_node, uint32_t second_node, double radius,
+            std::vector<std::pair<uint32_t, uint32_t>>& result) const;
 };
 
-std::pair<Vector, Vector> Segment::split_on_three_parts() const {
-    Vector first = start + ((1./3) * direction);
-    Vector second = start + ((2./3) * direction);
-    return std::make_pair(first, second);
+Segment_bvh::Segment_bvh(const std::vector<Segment>& _segments) : segments(_segments) {
+    boxes.reserve(segments.size());
+    order.resize(segments.size());
+    for (uint32_t i = 0; i < segments.size(); ++i) {
+        boxes.emplace_back(segments[i]);
+        order[i] = i;
+    }
+    nodes.reserve(2 * segments.size() / max_leaf_size + 1);
+    if (!segments.empty()) build(0, segments.size());
 }
 
-//class Set_of_Objects must have function split_on_three_parts and constructor
-//form two Objects
-template<class Object, class Set_of_Objects>
-std::pair<double, Object> ternary_search(const Object& dot, const Set_of_Objects& segment,
-        double (*distance)(const Object&, const Object&), double epsilon) {
+void Segment_bvh::build(uint32_t from, uint32_t to) {
+    uint32_t index = nodes.size();
+    nodes.push_back(Node());
+    Box box;
+    Box centroids;
+    for (uint32_t i = from; i < to; ++i) {
+        box.add(boxes[order[i]]);
+        centroids.add(Vector(0.5 * (boxes[order[i]].min[0] + boxes[order[i]].max[0]),
+                             0.5 * (boxes[order[i]].min[1] + boxes[order[i]].max[1]),
+                             0.5 * (boxes[order[i]].min[2] + boxes[order[i]].max[2])));
+    }
+    nodes[index].box = box;
 
-    std::pair<Object, Object> dots = segment.split_on_three_parts();
-    Set_of_Objects cur_seg(segment);
-    double  result = 0;
-    while (cur_seg.length() > epsilon) {
-        double first_dist = distance(dot, dots.first);
-        double second_dist = distance(dot, dots.second);
+    size_t axis = 0;
+    for (size_t k = 1; k < 3; ++k) {
+        if (centroids.max[k] - centroids.min[k] > centroids.max[axis] - centroids.min[axis]) axis = k;
+    }
+    double extent = centroids.max[axis] - centroids.min[axis];
+    if (to - from <= max_leaf_size || extent <= 0) {
+        nodes[index].first = from;
+        nodes[index].count = to - from;
+        return;
+    }
 
-        if (first_dist > second_dist) {
-            cur_seg = Set_of_Objects(dots.first, cur_seg.end);
-        }
-        else {
-            cur_seg = Set_of_Objects(cur_seg.start, dots.second);
+    auto bin_of = [&](uint32_t segment) {
+        double centroid = 0.5 * (boxes[segment].min[axis] + boxes[segment].max[axis]);
+        auto bin = static_cast<size_t>((centroid - centroids.min[axis]) / extent * bins_amount);
+        return std::min(bin, bins_amount - 1);
+    };
+    std::array<Box, bins_amount> bin_boxes;
+    std::array<uint32_t, bins_amount> bin_counts = {};
+    for (uint32_t i = from; i < to; ++i) {
+        size_t bin = bin_of(order[i]);
+        bin_boxes[bin].add(boxes[order[i]]);
+        ++bin_counts[bin];
+    }
+
+    //cost of split after bin b is area(left) * count(left) + area(right) * count(right)
+    std::array<double, bins_amount> left_cost;
+    Box left;
+    uint32_t left_count = 0;
+    for (size_t b = 0; b + 1 < bins_amount; ++b) {
+        left.add(bin_boxes[b]);
+        left_count += bin_counts[b];
+        left_cost[b] = left.half_area() * left_count;
+    }
+    Box right;
+    uint32_t right_count = 0;
+    size_t best_split = 0;
+    double best_cost = std::numeric_limits<double>::infinity();
+    for (size_t b = bins_amount - 1; b > 0; --b) {
+        right.add(bin_boxes[b]);
+        right_count += bin_counts[b];
+        double cost = left_cost[b - 1] + right.half_area() * right_count;
+        if (cost < best_cost) {
+            best_cost = cost;
+            best_split = b - 1;
         }
-        dots = cur_seg.split_on_three_parts();
-        result = 0.5 * (first_dist + second_dist);
     }
-    return std::make_pair(result, 0.5 * (dots.first + dots.second));
+
+    auto middle = std::partition(order.begin() + from, order.begin() + to,
+                                 [&](uint32_t segment) { return bin_of(segment) <= best_split; });
+    auto middle_index = static_cast<uint32_t>(middle - order.begin());
+    if (middle_index == from || middle_index == to) middle_index = from + (to - from) / 2;
+
+    build(from, middle_index);
+    nodes[index].first = nodes.size();
+    nodes[index].count = 0;
+    build(middle_index, to);
 }
 
-double find_distance_between_segments(const Segment& first, const Segment& second) {
-    const double epsilon = 0.00000001;
-    Segment _first(first);
-    double result;
-    std::pair<Vector, Vector> f_dots, s_dots; //dots which will be returned by split in ternary search
-    //prefix f_ means that Vectors are from segment first, s_ -- from second
-    f_dots = first.split_on_three_parts();
-    s_dots = second.split_on_three_parts();
-    do {
-        s_dots.first = ternary_search<Vector, Segment>(f_dots.first, second, distance, epsilon).second;
-        s_dots.second = ternary_search<Vector, Segment>(f_dots.second, second, distance, epsilon).second;
-        double s_first_dist = distance(f_dots.first, s_dots.first);
-        double s_second_dist = distance(f_dots.second, s_dots.second);
-
-        if (s_first_dist > s_second_dist) {
-            _first = Segment(f_dots.first, _first.start + _first.direction);
+std::pair<uint32_t, Closest_points> Segment_bvh::find_nearest(const Segment& query) const {
+    std::vector<std::pair<double, uint32_t>> nearest = find_k_nearest(query, 1);
+    if (nearest.empty()) return std::make_pair(UINT32_MAX, Closest_points());
+    return std::make_pair(nearest[0].second, find_closest_points_between_segments(query, segments[nearest[0].second]));
+}
+
+std::vector<std::pair<double, uint32_t>> Segment_bvh::find_k_nearest(const Segment& query, size_t k) const {
+    std::vector<std::pair<double, uint32_t>> best; //max heap of found (distance, index)
+    if (nodes.empty() || k == 0) return best;
+    Box query_box(query);
+    auto bound = [&]() { //squared distance, farther than which nothing is needed
+        return (best.size() < k ? std::numeric_limits<double>::infinity() : best.front().first * best.front().first);
+    };
+
+    std::vector<std::pair<double, uint32_t>> stack = {{squared_distance(query_box, nodes[0].box), 0}};
+    while (!stack.empty()) {
+        auto current = stack.back();
+        stack.pop_back();
+        if (current.first > bound()) continue;
+        const Node& node = nodes[current.second];
+        if (node.count > 0) {
+            for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+                if (squared_distance(query_box, boxes[order[i]]) > bound()) continue;
+                double dist = find_distance_between_segments(query, segments[order[i]]);
+                if (best.size() < k || dist < best.front().first) {
+                    if (best.size() == k) {
+                        std::pop_heap(best.begin(), best.end());
+                        best.pop_back();
+                    }
+                    best.emplace_back(dist, order[i]);
+                    std::push_heap(best.begin(), best.end());
+                }
+            }
+            continue;
+        }
+        double left = squared_distance(query_box, nodes[current.second + 1].box);
+        double right = squared_distance(query_box, nodes[node.first].box);
+        if (left < right) { //closer child is visited first
+            stack.emplace_back(right, node.first);
+            stack.emplace_back(left, current.second + 1);
         }
         else {
-            _first = Segment(_first.start, f_dots.second);
+            stack.emplace_back(left, current.second + 1);
+            stack.emplace_back(right, node.first);
         }
-        f_dots = _first.split_on_three_parts();
-    } while (_first.length() > epsilon);
+    }
+    std::sort_heap(best.begin(), best.end());
+    return best;
+}
 
-    result = distance(0.5 * (f_dots.second + f_dots.first), 0.5 * (s_dots.second + s_dots.first));
+std::vector<std::pair<uint32_t, uint32_t>> Segment_bvh::find_pairs_within_radius(double radius) const {
+    std::vector<std::pair<uint32_t, uint32_t>> result;
+    if (!nodes.empty()) collect_pairs(0, 0, radius, result);
     return result;
 }
 
-int main() {
+void Segment_bvh::collect_pairs(uint32_t first_node, uint32_t second_node, double radius,
+        std::vector<std::pair<uint32_t, uint32_t>>& result) const {
+    const Node& first = nodes[first_node];
+    const Node& second = nodes[second_node];
+    if (squared_distance(first.box, second.box) > radius * radius) return;
+
+    if (first.count > 0 && second.count > 0) {
+        for (uint32_t i = first.first; i < first.first + first.count; ++i) {
+            //inside one leaf every pair is met once
+            uint32_t j = (first_node == second_node ? i + 1 : second.first);
+            for (; j < second.first + second.count; ++j) {
+                if (squared_distance(boxes[order[i]], boxes[order[j]]) > radius * radius) continue;
+                if (find_distance_between_segments(segments[order[i]], segments[order[j]]) <= radius)
+                    result.emplace_back(std::min(order[i], order[j]), std::max(order[i], order[j]));
+            }
+        }
+    }
+    else if (first_node == second_node) { //pairs inside node are inside children or between them
+        collect_pairs(first_node + 1, first_node + 1, radius, result);
+        collect_pairs(first.first, first.first, radius, result);
+        collect_pairs(first_node + 1, first.first, radius, result);
+    }
+    else if (second.count > 0 || (first.count == 0 && first.box.half_area() > second.box.half_area())) {
+        collect_pairs(first_node + 1, second_node, radius, result);
+        collect_pairs(first.first, second_node, radius, result);
+    }
+    else {
+        collect_pairs(first_node, second_node + 1, radius, result);
+        collect_pairs(first_node, second.first, radius, result);
+    }
+}
+
+void benchmark() {
+    constexpr size_t pairs_amount = 1000;
+    std::mt19937 generator(2020);
+    std::uniform_real_distribution<double> coordinate(-100, 100);
+    std::vector<Segment> segments;
+    for (size_t i = 0; i < 2 * pairs_amount; ++i) {
+        Vector start(coordinate(generator), coordinate(generator), coordinate(generator));
+        Vector end(coordinate(generator), coordinate(generator), coordinate(generator));
+        segments.emplace_back(start, end);
+    }
+
+    std::vector<double> expected(pairs_amount);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < pairs_amount; ++i) {
+        expected[i] = find_distance_between_segments(segments[2 * i], segments[2 * i + 1]);
+    }
+    std::chrono::duration<double, std::nano> closed_form = std::chrono::steady_clock::now() - start;
+    printf("closed form: %.1f ns per pair\n", closed_form.count() / pairs_amount);
+
+    Minimization_options fixed_golden;
+    fixed_golden.iterations = 40;
+    std::pair<const char*, Minimization_options> searches[] = {
+            {"nested ternary", {Minimization_method::ternary}},
+            {"nested golden section", {Minimization_method::golden_section}},
+            {"nested brent", {Minimization_method::brent}},
+            {"nested golden section, 40 iterations", fixed_golden}};
+    for (auto& search : searches) {
+        size_t evaluations = 0;
+        double max_difference = 0;
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < pairs_amount; ++i) {
+            double result = find_distance_between_segments_by_ternary_search(segments[2 * i], segments[2 * i + 1],
+                                                                             search.second, &evaluations);
+            max_difference = std::max(max_difference, std::abs(result - expected[i]));
+        }
+        std::chrono::duration<double, std::nano> time = std::chrono::steady_clock::now() - start;
+        printf("%s: %.1f ns, %.0f distance evaluations per pair, max difference: %.3e\n", search.first,
+               time.count() / pairs_amount, static_cast<double>(evaluations) / pairs_amount, max_difference);
+    }
+}
+
+void benchmark_batch() {
+    constexpr size_t segments_amount = 1 << 12;
+    constexpr size_t pairs_amount = 1 << 22;
+    std::mt19937 generator(2020);
+    std::uniform_real_distribution<double> coordinate(-100, 100);
+    std::uniform_int_distribution<uint32_t> index(0, segments_amount - 1);
+    std::vector<Segment> segments;
+    Segment_batch batch;
+    for (size_t i = 0; i < segments_amount; ++i) {
+        Vector start(coordinate(generator), coordinate(generator), coordinate(generator));
+        Vector end(coordinate(generator), coordinate(generator), coordinate(generator));
+        segments.emplace_back(start, end);
+        batch.add(segments.back());
+    }
+    std::vector<uint32_t> first_indices(pairs_amount);
+    std::vector<uint32_t> second_indices(pairs_amount);
+    for (size_t i = 0; i < pairs_amount; ++i) {
+        first_indices[i] = index(generator);
+        second_indices[i] = index(generator);
+    }
+
+    std::vector<double> expected(pairs_amount);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < pairs_amount; ++i) {
+        expected[i] = find_distance_between_segments(segments[first_indices[i]], segments[second_indices[i]]);
+    }
+    std::chrono::duration<double, std::nano> single = std::chrono::steady_clock::now() - start;
+
+    std::vector<double> result;
+    start = std::chrono::steady_clock::now();
+    find_distances_between_segments(batch, batch, first_indices, second_indices, result);
+    std::chrono::duration<double, std::nano> listed = std::chrono::steady_clock::now() - start;
+
+    std::vector<double> all_pairs;
+    start = std::chrono::steady_clock::now();
+    find_distances_between_segments(batch, batch, all_pairs);
+    std::chrono::duration<double, std::nano> pairwise = std::chrono::steady_clock::now() - start;
+
+    double max_difference = 0;
+    for (size_t i = 0; i < pairs_amount; ++i) {
+        max_difference = std::max(max_difference, std::abs(result[i] - expected[i]));
+        max_difference = std::max(max_difference, std::abs(
+                all_pairs[first_indices[i] * segments_amount + second_indices[i]] - expected[i]));
+    }
+    printf("lanes: %zu, threads: %u\none by one: %.2f ns per pair\nlisted pairs: %.2f ns per pair\n"
+           "all pairs: %.2f ns per pair\nmax difference: %.3e\n", widest_pack_size,
+           std::thread::hardware_concurrency(), single.count() / pairs_amount, listed.count() / pairs_amount,
+           pairwise.count() / all_pairs.size(), max_difference);
+}
+
+void benchmark_bvh() {
+    constexpr size_t segments_amount = 1000000;
+    constexpr size_t queries_amount = 1000;
+    constexpr size_t checked_queries = 20;
+    std::mt19937 generator(2020);
+    std::uniform_real_distribution<double> coordinate(0, 1000);
+    std::uniform_real_distribution<double> shift(-1, 1);
+    auto random_segment = [&]() {
+        Vector start(coordinate(generator), coordinate(generator), coordinate(generator));
+        return Segment(start, start + Vector(shift(generator), shift(generator), shift(generator)));
+    };
+    std::vector<Segment> segments;
+    for (size_t i = 0; i < segments_amount; ++i) segments.push_back(random_segment());
+    std::vector<Segment> queries;
+    for (size_t i = 0; i < queries_amount; ++i) queries.push_back(random_segment());
+
+    auto start = std::chrono::steady_clock::now();
+    Segment_bvh bvh(segments);
+    std::chrono::duration<double, std::milli> build = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    double checksum = 0;
+    for (auto& query : queries) checksum += bvh.find_nearest(query).second.distance;
+    std::chrono::duration<double, std::micro> nearest = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (auto& query : queries) checksum += bvh.find_k_nearest(query, 8).back().first;
+    std::chrono::duration<double, std::micro> k_nearest = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    size_t pairs = bvh.find_pairs_within_radius(0.5).size();
+    std::chrono::duration<double, std::milli> within_radius = std::chrono::steady_clock::now() - start;
+
+    size_t mismatches = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t q = 0; q < checked_queries; ++q) {
+        double best = std::numeric_limits<double>::infinity();
+        for (auto& segment : segments) best = std::min(best, find_distance_between_segments(queries[q], segment));
+        mismatches += (best != bvh.find_nearest(queries[q]).second.distance);
+    }
+    std::chrono::duration<double, std::micro> brute_force = std::chrono::steady_clock::now() - start;
+
+    printf("segments: %zu, build: %.1f ms\nnearest: %.2f us per query, brute force: %.0f us per query, "
+           "mismatches: %zu\n8 nearest: %.2f us per query\npairs within 0.5: %zu in %.1f ms\n",
+           segments_amount, build.count(), nearest.count() / queries_amount, brute_force.count() / checked_queries,
+           mismatches, k_nearest.count() / queries_amount, pairs, within_radius.count());
+}
+
+//usage: module3_solutionA [--bench | --bench-batch | --bench-bvh]
+int main(int argc, char* argv[]) {
+    std::string mode = (argc > 1 ? argv[1] : "");
+    if (mode == "--bench") {
+        benchmark();
+        return 0;
+    }
+    if (mode == "--bench-batch") {
+        benchmark_batch();
+        return 0;
+    }
+    if (mode == "--bench-bvh") {
+        benchmark_bvh();
+        return 0;
+    }
+
     double x1, y1, z1, x2, y2, z2, x3, y3, z3, x4, y4, z4;
     std::cin >> x1 >> y1 >> z1;
     std::cin >> x2 >> y2 >> z2;
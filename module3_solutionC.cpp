@@ -11,82 +11,50 @@
 #include <iostream>
 #include <cmath>
 #include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <cstdint>
+#include <utility>
+#include <limits>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#include "geometry.h"
+#include "predicates.h"
 
-double abs(double x) {
-    return (x > 0 ? x : -x);
-}
+using Vector = geometry::Vector<double, 2>;
 
 bool is_same_sign(double first, double second) {
     return ((first >= 0 && second >= 0) || (first <= 0 && second <= 0));
 }
 
-struct Vector {
-    Vector() = default;
-    explicit Vector(double _x, double _y) :  x(_x), y(_y) {}
-    explicit Vector(const Vector& start, const Vector& end) {
-        x = end.x - start.x;
-        y = end.y - start.y;
-    }
-
-    double length() const {
-        return sqrt(x*x + y*y);
-    }
-
-    friend double scalar_product(const Vector& first, const Vector& second) {
-        return first.x * second.x + first.y * second.y;
-    }
-
-    friend double vector_product(const Vector& first, const Vector& second) {
-        return first.x * second.y - second.x * first.y;
-    }
-
-    friend Vector proection(const Vector& base, const Vector& to_be_proected) {
-        Vector result;
-        double coef = scalar_product(base, to_be_proected) / base.length();
-        result.x = base.x / abs(base.x) * coef;
-        result.y = base.y / abs(base.y) * coef;
-        return result;
-    }
-
-    friend Vector operator+(const Vector& first, const Vector& second) {
-        Vector result;
-        result.x = first.x + second.x;
-        result.y = first.y + second.y;
-        return result;
-    }
-
-    friend Vector operator-(const Vector& first, const Vector& second) {
-        Vector result;
-        result.x = first.x - second.x;
-        result.y = first.y - second.y;
-        return result;
-    }
-
-    friend Vector operator*(double number, const Vector& vect) {
-        Vector result(vect);
-        result.x  *= number;
-        result.y  *= number;
-        return result;
-    }
-
-    double x;
-    double y;
-};
-
-double distance(const Vector& first, const Vector& second) {
-    double result = sqrt((first.x - second.x) * (first.x - second.x)
-                         + (first.y - second.y) * (first.y - second.y));
-    return result;
+//true if direction first has less polar angle in [0, 2pi) than second; equal directions are not less
+bool is_before_by_angle(const Vector& first, const Vector& second) {
+    bool first_lower = (first.y < 0 || (first.y == 0 && first.x < 0)); //angle in [pi, 2pi)
+    bool second_lower = (second.y < 0 || (second.y == 0 && second.x < 0));
+    if (first_lower != second_lower) return second_lower;
+    return geometry::orient2d(Vector(0, 0), first, second) > 0;
 }
 
-bool is_less_polar_angle(const Vector& first, const Vector& second) {
-    double vect_prod = vector_product(first, second);
-    if (vect_prod != 0) {
-        return vect_prod > 0;
-    }
-    else {
-        return scalar_product(first, second) > 0;
+//merge path of two sequences of edges sorted by polar angle: the amount of edges of the first sequence among
+//the first k merged edges, edges of the first sequence go first if directions are equal
+template <class First_edge, class Second_edge>
+std::size_t find_merge_path(std::size_t k, std::size_t n, std::size_t m, First_edge first_edge,
+        Second_edge second_edge) {
+    std::size_t low = (k > m ? k - m : 0); //the least i such that second edge k - i - 1 goes before first edge i
+    std::size_t high = std::min(k, n);
+    while (low < high) {
+        std::size_t middle = (low + high) / 2;
+        if (is_before_by_angle(second_edge(k - middle - 1), first_edge(middle)))
+            high = middle;
+        else
+            low = middle + 1;
     }
+    return low;
 }
 
 
@@ -98,6 +66,10 @@ public:
         vertices.push_back(dot);
     }
 
+    void resize(std::size_t count) {
+        vertices.resize(count);
+    }
+
     Vector& operator[](std::size_t index) {
         return vertices[index];
     }
@@ -117,13 +89,41 @@ private:
     std::vector<Vector> vertices;
 };
 
+//turns are taken in double, while the greatest difference of coordinates of a vertex and dot and the least absolute
+//value of nonzero turns are tracked; if a turn seen is below the static filter for this width, the walk is repeated
+//and such turns are taken by geometry::orient2d
 bool Polygon::is_inner(const Vector &dot) {
-    double first_prod = vector_product(vertices[vertices.size() - 1] - dot,
-            vertices[0] - vertices[vertices.size() - 1]);
+    const Vector* last = &vertices[vertices.size() - 1];
+    Vector previous = *last - dot;
+    double width = std::max(std::fabs(previous.x), std::fabs(previous.y));
+    double least = std::numeric_limits<double>::infinity();
+    double first_prod = 0;
+    bool is_inner = true;
+    for (const Vector& vertex : vertices) {
+        const Vector current = vertex - dot;
+        double prod = vector_product(previous, current);
+        if (prod == 0) prod = geometry::orient2d(dot, *last, vertex); //exact at once if dot is a vertex
+        else least = std::min(least, std::fabs(prod));
+        width = std::max(width, std::max(std::fabs(current.x), std::fabs(current.y)));
+        previous = current;
+        last = &vertex;
+        if (first_prod == 0) first_prod = prod; //dot is on the line of the last edge, sign is given by next edges
+        else if (!is_same_sign(first_prod, prod)) {
+            is_inner = false;
+            break;
+        }
+    }
+    const double bound = geometry::Static_error_bounds(width).orient;
+    if (least >= bound) return is_inner;
 
-    for (int i = 1; i < vertices.size(); ++i) {
-        if (!is_same_sign(first_prod, vector_product(vertices[i - 1] - dot, vertices[i] - vertices[i - 1])))
-            return false;
+    last = &vertices[vertices.size() - 1];
+    first_prod = 0;
+    for (const Vector& vertex : vertices) {
+        double prod = vector_product(*last - dot, vertex - dot);
+        if (std::fabs(prod) < bound) prod = geometry::orient2d(dot, *last, vertex);
+        last = &vertex;
+        if (first_prod == 0) first_prod = prod;
+        else if (!is_same_sign(first_prod, prod)) return false;
     }
     return true;
 }
@@ -146,50 +146,1017 @@ void Polygon::orient() {
     }
 }
 
-Polygon create_by_Minkowski_sum(const Polygon& first, const Polygon& second) {
-    Polygon result;
-    int i = 0;
-    int j = 0;
+//edge from vertex index of polygon to the next one
+Vector edge_of(const Polygon& polygon, std::size_t index) {
+    return polygon[index + 1 == polygon.count() ? 0 : index + 1] - polygon[index];
+}
 
-    while (i < first.count() - 1 && j < second.count() - 1) {
-        result.add_to_polygon(first[i] + second[j]);
-        if (is_less_polar_angle(first[i + 1] - first[i], second[j + 1] - second[j]))
+//writes vertices [from, to) of the sum of oriented polygons, first[i] + second[j] is vertex from
+void merge_Minkowski_sum_part(const Polygon& first, const Polygon& second, std::size_t i, std::size_t j,
+        std::size_t from, std::size_t to, Polygon& result) {
+    const std::size_t n = first.count();
+    const std::size_t m = second.count();
+    for (std::size_t k = from; k < to; ++k) {
+        result[k] = first[i == n ? 0 : i] + second[j == m ? 0 : j];
+        if (j == m || (i < n && !is_before_by_angle(edge_of(second, j), edge_of(first, i))))
             ++i;
         else
             ++j;
     }
-    if (i == first.count() - 1) {
-        for (; j < second.count(); ++j) {
-            result.add_to_polygon(first[i] + second[j]);
-            if (i != 0 && is_less_polar_angle(first[0] - first[i], second[j + 1] - second[j])) {
-                i = 0;
-                --j;
+}
+
+//polygons are oriented; vertex k of the sum is first[i] + second[k - i], where i edges of first go before
+Polygon create_by_Minkowski_sum(const Polygon& first, const Polygon& second) {
+    Polygon result;
+    result.resize(first.count() + second.count());
+    merge_Minkowski_sum_part(first, second, 0, 0, 0, result.count(), result);
+    return result;
+}
+
+constexpr std::size_t min_vertices_per_thread = 1 << 16;
+
+//the same vertices as create_by_Minkowski_sum: output is split into equal parts, the start of every part
+//in both polygons is found by merge path binary search, and parts are merged in parallel threads
+Polygon create_by_Minkowski_sum_parallel(const Polygon& first, const Polygon& second) {
+    const std::size_t n = first.count();
+    const std::size_t m = second.count();
+    Polygon result;
+    result.resize(n + m);
+    geometry::parallel_for(n + m, min_vertices_per_thread, [&](std::size_t from, std::size_t to) {
+        std::size_t i = find_merge_path(from, n, m, [&first](std::size_t index) { return edge_of(first, index); },
+                                        [&second](std::size_t index) { return edge_of(second, index); });
+        merge_Minkowski_sum_part(first, second, i, from - i, from, to, result);
+    });
+    return result;
+}
+
+bool is_intersection(Polygon first, Polygon second) {
+    for (int i = 0; i < second.count(); ++i){
+        second[i] = (-1) * second[i];
+    }
+    first.orient();
+    second.orient();
+    Polygon mink_sum = create_by_Minkowski_sum(first, second);
+    return mink_sum.is_inner(Vector(0, 0));
+}
+
+//polygon given clockwise (or polygon -P) seen counterclockwise from the lowest (then the leftmost) vertex
+//by reversed iteration from rotated index, vertices are not copied
+class Oriented_view {
+public:
+    Oriented_view(const Polygon& _polygon, bool _is_reflected);
+
+    std::size_t count() const {
+        return polygon.count();
+    }
+
+    Vector operator[](std::size_t index) const { //index <= count()
+        std::size_t original = (index <= start ? start - index : start + polygon.count() - index);
+        return (is_reflected ? -polygon[original] : polygon[original]);
+    }
+
+    Vector edge(std::size_t index) const {
+        return (*this)[index + 1] - (*this)[index];
+    }
+
+private:
+    const Polygon& polygon;
+    bool is_reflected;
+    std::size_t start = 0;
+};
+
+Oriented_view::Oriented_view(const Polygon& _polygon, bool _is_reflected)
+        : polygon(_polygon)
+        , is_reflected(_is_reflected) {
+    for (std::size_t i = 1; i < polygon.count(); ++i) {
+        Vector current = (is_reflected ? -polygon[i] : polygon[i]);
+        Vector best = (is_reflected ? -polygon[start] : polygon[start]);
+        if (current.y < best.y || (current.y == best.y && current.x < best.x)) start = i;
+    }
+}
+
+//without building Minkowski sum: edges of first and -second are merged by polar angle on the fly and zero is
+//checked against every edge of the sum as soon as it appears; no allocations, one pass over both polygons
+bool is_intersection_in_place(const Polygon& first, const Polygon& second) {
+    Oriented_view summand(first, false);
+    Oriented_view reflected(second, true);
+    const std::size_t n = summand.count();
+    const std::size_t m = reflected.count();
+    std::size_t i = 0;
+    std::size_t j = 0;
+    while (i < n || j < m) {
+        Vector vertex = summand[i] + reflected[j];
+        Vector edge;
+        if (j == m || (i < n && !is_before_by_angle(reflected.edge(j), summand.edge(i)))) {
+            edge = summand.edge(i++);
+        }
+        else {
+            edge = reflected.edge(j++);
+        }
+        if (geometry::orient2d(Vector(0, 0), vertex, edge) < 0) return false; //zero is to the right of the edge
+    }
+    return true;
+}
+
+//value is distance between points first and second
+struct Witnessed_distance {
+    double value;
+    Vector first;
+    Vector second;
+};
+
+//the closest to zero point of Minkowski sum first + (-second) is searched on its edges, which are merged
+//from both polygons on the fly as in is_intersection_in_place: witnesses are the point of the edge of one
+//polygon and the vertex of the other; for intersecting polygons value is 0, and second moved by
+//first - second of witnesses only touches first
+Witnessed_distance find_distance_between_polygons(const Polygon& first, const Polygon& second) {
+    Oriented_view summand(first, false);
+    Oriented_view reflected(second, true);
+    const std::size_t n = summand.count();
+    const std::size_t m = reflected.count();
+    Witnessed_distance result{std::numeric_limits<double>::infinity(), summand[0], -reflected[0]};
+    bool is_inside = true;
+    std::size_t i = 0;
+    std::size_t j = 0;
+    while (i < n || j < m) {
+        Vector vertex = summand[i] + reflected[j];
+        bool is_edge_of_first = (j == m || (i < n && !is_before_by_angle(reflected.edge(j), summand.edge(i))));
+        Vector edge = (is_edge_of_first ? summand.edge(i) : reflected.edge(j));
+        if (geometry::orient2d(Vector(0, 0), vertex, edge) < 0) is_inside = false;
+
+        double part = 0; //of the edge to the closest to zero point
+        if (edge.squared_length() > 0)
+            part = std::min(std::max(-scalar_product(vertex, edge) / edge.squared_length(), 0.), 1.);
+        double squared_distance = (vertex + part * edge).squared_length();
+        if (squared_distance < result.value) {
+            result.value = squared_distance;
+            result.first = summand[i] + (is_edge_of_first ? part * edge : Vector(0, 0));
+            result.second = -(reflected[j] + (is_edge_of_first ? Vector(0, 0) : part * edge));
+        }
+        if (is_edge_of_first) ++i;
+        else ++j;
+    }
+    result.value = (is_inside ? 0 : std::sqrt(result.value));
+    return result;
+}
+
+//true if the end of next edge is not nearer to the line of edge than its start and the caliper moves on: next turns
+//left from edge or goes in the same direction, as edges between collinear vertices do
+bool is_moving_away(const Vector& edge, const Vector& next) {
+    double turn = geometry::orient2d(Vector(0, 0), edge, next);
+    return turn > 0 || (turn == 0 && scalar_product(edge, next) > 0);
+}
+
+//for every edge of polygon the farthest from its line vertex is found by the second caliper, which only moves
+//forward: calls check(edge, vertex) for all n pairs in O(n)
+template <class Check>
+void rotate_calipers(const Oriented_view& polygon, Check check) {
+    const std::size_t n = polygon.count();
+    std::size_t j = 1 % n;
+    for (std::size_t i = 0; i < n; ++i) {
+        Vector edge = polygon.edge(i);
+        for (std::size_t steps = 0; steps < n && is_moving_away(edge, polygon.edge(j)); ++steps) {
+            j = (j + 1 == n ? 0 : j + 1);
+        }
+        check(i, j);
+    }
+}
+
+//the farthest pair of vertices, the pair is antipodal to some edge
+Witnessed_distance find_diameter(const Polygon& polygon) {
+    Oriented_view view(polygon, false);
+    Witnessed_distance result{0, view[0], view[0]};
+    rotate_calipers(view, [&](std::size_t edge, std::size_t vertex) {
+        for (std::size_t end : {edge, edge + 1}) {
+            double squared_distance = Vector(view[end], view[vertex]).squared_length();
+            if (squared_distance > result.value) result = {squared_distance, view[end], view[vertex]};
+        }
+    });
+    result.value = std::sqrt(result.value);
+    return result;
+}
+
+//the least distance between parallel support lines, one of which goes through an edge; witnesses are
+//the farthest vertex from that edge and its projection to the line of the edge
+Witnessed_distance find_width(const Polygon& polygon) {
+    Oriented_view view(polygon, false);
+    Witnessed_distance result{std::numeric_limits<double>::infinity(), view[0], view[0]};
+    if (view.count() < 3) {
+        result.value = 0;
+        return result;
+    }
+    rotate_calipers(view, [&](std::size_t edge, std::size_t vertex) {
+        Vector direction = view.edge(edge);
+        if (direction.squared_length() == 0) return;
+        double width = vector_product(direction, Vector(view[edge], view[vertex])) / direction.length();
+        if (width < result.value) {
+            result = {width, view[edge] + proection(direction, Vector(view[edge], view[vertex])), view[vertex]};
+        }
+    });
+    return result;
+}
+
+constexpr std::size_t min_polygon_pairs_per_thread = 1 << 6;
+
+//result[k] is distance between polygons of pairs[k]
+void find_distances_between_polygons(const std::vector<Polygon>& polygons,
+        const std::vector<std::pair<uint32_t, uint32_t>>& pairs, std::vector<Witnessed_distance>& result) {
+    result.resize(pairs.size());
+    geometry::parallel_for(pairs.size(), min_polygon_pairs_per_thread, [&](std::size_t from, std::size_t to) {
+        for (std::size_t k = from; k < to; ++k) {
+            result[k] = find_distance_between_polygons(polygons[pairs[k].first], polygons[pairs[k].second]);
+        }
+    });
+}
+
+//polygon oriented once: vertices go counterclockwise from the lowest (then the leftmost) one, so edge directions
+//increase by polar angle; the highest (then the rightmost) vertex is remembered, reflected polygon -P
+//starts from it and is available without copies
+class Prepared_polygon {
+public:
+    explicit Prepared_polygon(Polygon polygon);
+
+    std::size_t count() const {
+        return vertices.size();
+    }
+
+    const Vector& operator[](std::size_t index) const {
+        return vertices[index];
+    }
+
+    const Vector& edge(std::size_t index) const { //from vertex index to the next one
+        return edges[index];
+    }
+
+    Vector reflected(std::size_t index) const { //vertices of -P in the same order, index <= count()
+        return -vertices[cyclic(top + index)];
+    }
+
+    Vector reflected_edge(std::size_t index) const {
+        return -edges[cyclic(top + index)];
+    }
+
+    double reach() const { //the greatest difference of coordinates of a vertex and vertex 0
+        return vertex_reach;
+    }
+
+    double magnitude() const { //the greatest absolute value of coordinates of vertices
+        return vertex_magnitude;
+    }
+
+    void translate(const Vector& shift) { //orientation, edges and top vertex do not change
+        for (auto& vertex : vertices) vertex += shift;
+        measure(); //rounding of coordinates may change reach a little
+    }
+
+    bool contains(const Vector& dot) const; //O(log n), dots on the border are inside
+
+    //result[i] is 1 if dots[i] is inside; parts of dots are classified in parallel threads by vector lanes
+    void contains(const geometry::Vector_array<double, 2>& dots, std::vector<uint8_t>& result) const;
+
+private:
+    std::size_t cyclic(std::size_t index) const { //index < 2 * count() without division
+        return (index < vertices.size() ? index : index - vertices.size());
+    }
+
+    void measure();
+
+    void classify(const double* x, const double* y, std::size_t from, std::size_t to, uint8_t* result) const;
+
+    std::vector<Vector> vertices;
+    std::vector<Vector> edges;
+    std::size_t top = 0;
+    double vertex_reach = 0;
+    double vertex_magnitude = 0;
+};
+
+Prepared_polygon::Prepared_polygon(Polygon polygon) {
+    polygon.orient();
+    vertices.reserve(polygon.count());
+    edges.reserve(polygon.count());
+    for (std::size_t i = 0; i < polygon.count(); ++i) {
+        vertices.push_back(polygon[i]);
+        edges.push_back(polygon[(i + 1) % polygon.count()] - polygon[i]);
+        if (vertices[top].y < vertices[i].y || (vertices[top].y == vertices[i].y && vertices[top].x < vertices[i].x))
+            top = i;
+    }
+    measure();
+}
+
+void Prepared_polygon::measure() {
+    vertex_reach = 0;
+    vertex_magnitude = 0;
+    for (const Vector& vertex : vertices) {
+        const Vector shift(vertices[0], vertex);
+        vertex_reach = std::max({vertex_reach, std::fabs(shift.x), std::fabs(shift.y)});
+        vertex_magnitude = std::max({vertex_magnitude, std::fabs(vertex.x), std::fabs(vertex.y)});
+    }
+}
+
+//vertices of Minkowski sum first + (-second) are computed on demand: vertex k is first[i] + (-second)[k - i],
+//where i is the amount of edges of first among the first k edges of merged by angle sequence
+class Implicit_Minkowski_difference {
+public:
+    Implicit_Minkowski_difference(const Prepared_polygon& _first, const Prepared_polygon& _second)
+            : first(_first)
+            , second(_second) { }
+
+    std::size_t count() const {
+        return first.count() + second.count();
+    }
+
+    Vector operator[](std::size_t k) const;
+
+    //vertex k - vertex 0 is a difference of vertices of first plus a difference of vertices of second, and both
+    //vertices are rounded sums
+    double reach() const {
+        const double rounding = 2 * geometry::exact::epsilon * (first.magnitude() + second.magnitude());
+        return first.reach() + 2 * second.reach() + rounding;
+    }
+
+private:
+    const Prepared_polygon& first;
+    const Prepared_polygon& second;
+};
+
+Vector Implicit_Minkowski_difference::operator[](std::size_t k) const {
+    const std::size_t n = first.count();
+    const std::size_t m = second.count();
+    std::size_t i = find_merge_path(k, n, m, [this](std::size_t index) { return first.edge(index); },
+                                    [this](std::size_t index) { return second.reflected_edge(index); });
+    return first[i == n ? 0 : i] + second.reflected(k - i == m ? 0 : k - i);
+}
+
+//inside or on the border of convex polygon given counterclockwise by vertices[0, count), search by angle
+//in the fan of triangles from vertices[0]; all vertices differ from vertices[0] by at most reach in every
+//coordinate, so turns are taken in double and only those below the static filter go to geometry::orient2d
+template <class Vertices>
+bool is_inner_convex(const Vertices& vertices, std::size_t count, const Vector& dot, double reach) {
+    if (count < 3) return false;
+    const Vector base = vertices[0];
+    const Vector to_dot(base, dot);
+    const double bound =
+            geometry::Static_error_bounds(2 * reach + std::max(std::fabs(to_dot.x), std::fabs(to_dot.y))).orient;
+    auto turn = [&](const Vector& vertex) { //of ray to vertex and dot
+        double product = vector_product(Vector(base, vertex), to_dot);
+        return (std::fabs(product) >= bound ? product : geometry::orient2d(base, vertex, dot));
+    };
+    if (turn(vertices[1]) < 0 || turn(vertices[count - 1]) > 0) return false;
+
+    std::size_t low = 1; //dot is in the angle between rays to vertices low and low + 1
+    std::size_t high = count - 1;
+    while (high - low > 1) {
+        std::size_t middle = (low + high) / 2;
+        if (turn(vertices[middle]) >= 0) low = middle;
+        else high = middle;
+    }
+    const Vector current(base, vertices[low]);
+    const Vector next(base, vertices[low + 1]);
+    double segment = vector_product(current, next);
+    if (std::fabs(segment) < bound) segment = geometry::orient2d(base, vertices[low], vertices[low + 1]);
+    if (segment == 0) {
+        //triangle is a segment, so dot is on the ray of the last edge: vertices from some index to count - 1 lie
+        //on it, and the farthest of them is the first one, it is searched in (0, low]
+        std::size_t before = 0;
+        std::size_t farthest = low;
+        while (farthest - before > 1) {
+            std::size_t middle = (before + farthest) / 2;
+            if (geometry::orient2d(base, vertices[count - 1], vertices[middle]) == 0) farthest = middle;
+            else before = middle;
+        }
+        const Vector farther(base, vertices[farthest]);
+        return scalar_product(farther, to_dot) >= 0 && to_dot.squared_length() <= farther.squared_length();
+    }
+    double edge = vector_product(vertices[low + 1] - vertices[low], dot - vertices[low]);
+    if (std::fabs(edge) < bound) edge = geometry::orient2d(vertices[low], vertices[low + 1], dot);
+    return edge >= 0;
+}
+
+//O(log(n + m) * log(min(n, m))): zero is searched in Minkowski sum first + (-second) without building it
+bool is_intersection(const Prepared_polygon& first, const Prepared_polygon& second) {
+    Implicit_Minkowski_difference difference(first, second);
+    return is_inner_convex(difference, difference.count(), Vector(0, 0), difference.reach());
+}
+
+bool Prepared_polygon::contains(const Vector& dot) const {
+    return is_inner_convex(vertices, vertices.size(), dot, vertex_reach);
+}
+
+constexpr std::size_t min_dots_per_thread = 1 << 16;
+
+void Prepared_polygon::contains(const geometry::Vector_array<double, 2>& dots, std::vector<uint8_t>& result) const {
+    result.assign(dots.size(), 0);
+    if (vertices.size() < 3) return;
+    geometry::parallel_for(dots.size(), min_dots_per_thread, [&](std::size_t from, std::size_t to) {
+        classify(dots.data(0), dots.data(1), from, to, result.data());
+    });
+}
+
+//same search as in is_inner_convex for 16 dots at once: binary search over the fan has fixed amount of steps,
+//vertices are gathered by indices of lanes and every check is computed and masked
+void Prepared_polygon::classify(const double* x, const double* y, std::size_t from, std::size_t to,
+        uint8_t* result) const {
+    const std::size_t count = vertices.size();
+#if defined(__AVX2__)
+    const Vector base = vertices[0];
+    const Vector first = vertices[1];
+    const Vector last = vertices[count - 1];
+    std::size_t top_step = 1; //the greatest power of two not greater than count - 2
+    while (2 * top_step <= count - 2) top_step *= 2;
+
+    static_assert(sizeof(Vector) == 2 * sizeof(double), "vertices are gathered as pairs of doubles");
+    const double* coordinates = reinterpret_cast<const double*>(vertices.data());
+    auto gather_x = [coordinates](__m256i index) { //index of vertex is doubled in lanes
+        return _mm256_i64gather_pd(coordinates, index, 8);
+    };
+    auto gather_y = [coordinates](__m256i index) {
+        return _mm256_i64gather_pd(coordinates + 1, index, 8);
+    };
+    auto cross = [](__m256d ax, __m256d ay, __m256d bx, __m256d by) {
+        return _mm256_sub_pd(_mm256_mul_pd(ax, by), _mm256_mul_pd(bx, ay));
+    };
+    const __m256d sign_bit = _mm256_set1_pd(-0.0);
+    const __m256d zero = _mm256_setzero_pd();
+    //geometry::orient2d of dots a, b, c in lanes with the static filter for the box of vertices and dot as in
+    //is_inner_convex: lanes where the sign is not sure are marked in uncertain and classified again by the scalar
+    //search; differences are taken from c as there, so c equal to a or b gives zero left product and a sure sign
+    auto filtered_turn = [sign_bit, zero](__m256d ax, __m256d ay, __m256d bx, __m256d by, __m256d cx, __m256d cy,
+            __m256d bound, __m256d& uncertain) {
+        __m256d left = _mm256_mul_pd(_mm256_sub_pd(ax, cx), _mm256_sub_pd(by, cy));
+        __m256d right = _mm256_mul_pd(_mm256_sub_pd(ay, cy), _mm256_sub_pd(bx, cx));
+        __m256d det = _mm256_sub_pd(left, right);
+        uncertain = _mm256_or_pd(uncertain, _mm256_and_pd(_mm256_cmp_pd(_mm256_andnot_pd(sign_bit, det), bound,
+                                                                        _CMP_LT_OQ),
+                                                          _mm256_cmp_pd(left, zero, _CMP_NEQ_OQ)));
+        return det;
+    };
+    const __m256d base_x = _mm256_set1_pd(base.x);
+    const __m256d base_y = _mm256_set1_pd(base.y);
+    const __m256d double_reach = _mm256_set1_pd(2 * vertex_reach);
+    const __m256d unit_bound = _mm256_set1_pd(geometry::Static_error_bounds(1).orient); //grows as square of width
+    const __m256i max_index = _mm256_set1_epi64x(2 * (count - 2));
+    constexpr std::size_t packs = 4; //searches of several packs are interleaved to hide latency of gathers
+    for (; from + 4 * packs <= to; from += 4 * packs) {
+        __m256d dot_x[packs], dot_y[packs], to_dot_x[packs], to_dot_y[packs], bound[packs], inside[packs];
+        __m256d uncertain[packs];
+        __m256i low[packs];
+        for (std::size_t p = 0; p < packs; ++p) {
+            dot_x[p] = _mm256_loadu_pd(x + from + 4 * p);
+            dot_y[p] = _mm256_loadu_pd(y + from + 4 * p);
+            to_dot_x[p] = _mm256_sub_pd(dot_x[p], base_x);
+            to_dot_y[p] = _mm256_sub_pd(dot_y[p], base_y);
+            __m256d width = _mm256_add_pd(double_reach, _mm256_max_pd(_mm256_andnot_pd(sign_bit, to_dot_x[p]),
+                                                                       _mm256_andnot_pd(sign_bit, to_dot_y[p])));
+            bound[p] = _mm256_mul_pd(unit_bound, _mm256_mul_pd(width, width));
+            uncertain[p] = zero;
+            inside[p] = _mm256_and_pd(
+                    _mm256_cmp_pd(filtered_turn(base_x, base_y, _mm256_set1_pd(first.x), _mm256_set1_pd(first.y),
+                                                dot_x[p], dot_y[p], bound[p], uncertain[p]), zero, _CMP_GE_OQ),
+                    _mm256_cmp_pd(filtered_turn(base_x, base_y, _mm256_set1_pd(last.x), _mm256_set1_pd(last.y),
+                                                dot_x[p], dot_y[p], bound[p], uncertain[p]), zero, _CMP_LE_OQ));
+            low[p] = _mm256_set1_epi64x(2);
+        }
+
+        for (std::size_t step = top_step; step > 0; step /= 2) {
+            for (std::size_t p = 0; p < packs; ++p) {
+                __m256i candidate = _mm256_add_epi64(low[p], _mm256_set1_epi64x(2 * step));
+                candidate = _mm256_blendv_epi8(candidate, max_index, _mm256_cmpgt_epi64(candidate, max_index));
+                //differences from the dot: a dot at a vertex gives zero with the vertex in any rounding
+                __m256d from_dot_x = _mm256_sub_pd(gather_x(candidate), dot_x[p]);
+                __m256d from_dot_y = _mm256_sub_pd(gather_y(candidate), dot_y[p]);
+                __m256d is_not_left = _mm256_cmp_pd(cross(from_dot_x, from_dot_y, to_dot_x[p], to_dot_y[p]), zero,
+                                                    _CMP_GE_OQ);
+                low[p] = _mm256_blendv_epi8(low[p], candidate, _mm256_castpd_si256(is_not_left));
             }
         }
+
+        for (std::size_t p = 0; p < packs; ++p) {
+            __m256i next = _mm256_add_epi64(low[p], _mm256_set1_epi64x(2));
+            __m256d current_x = gather_x(low[p]);
+            __m256d current_y = gather_y(low[p]);
+            __m256d next_x = gather_x(next);
+            __m256d next_y = gather_y(next);
+            //the search is not filtered, so the angle it has found is checked with the filter
+            __m256d is_wrong_angle = _mm256_or_pd(
+                    _mm256_cmp_pd(filtered_turn(base_x, base_y, current_x, current_y, dot_x[p], dot_y[p],
+                                                bound[p], uncertain[p]), zero, _CMP_LT_OQ),
+                    _mm256_and_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(max_index, low[p])),
+                                  _mm256_cmp_pd(filtered_turn(base_x, base_y, next_x, next_y, dot_x[p], dot_y[p],
+                                                              bound[p], uncertain[p]), zero, _CMP_GE_OQ)));
+            uncertain[p] = _mm256_or_pd(uncertain[p], _mm256_and_pd(inside[p], is_wrong_angle));
+            __m256d by_edge = _mm256_cmp_pd(filtered_turn(current_x, current_y, next_x, next_y, dot_x[p], dot_y[p],
+                                                          bound[p], uncertain[p]), zero, _CMP_GE_OQ);
+            __m256d is_segment = _mm256_cmp_pd(filtered_turn(base_x, base_y, current_x, current_y, next_x, next_y,
+                                                             bound[p], uncertain[p]), zero, _CMP_EQ_OQ);
+            //triangle is a segment: dot is on the ray of the last edge, the farthest collinear vertex on it is
+            //searched by the scalar search
+            uncertain[p] = _mm256_or_pd(uncertain[p], _mm256_and_pd(inside[p], is_segment));
+
+            int mask = _mm256_movemask_pd(_mm256_and_pd(inside[p], by_edge));
+            int uncertain_mask = _mm256_movemask_pd(uncertain[p]);
+            for (int k = 0; k < 4; ++k) {
+                std::size_t i = from + 4 * p + k;
+                bool is_uncertain = (uncertain_mask >> k) & 1;
+                result[i] = (is_uncertain ? is_inner_convex(vertices, count, Vector(x[i], y[i]), vertex_reach)
+                                          : (mask >> k) & 1);
+            }
+        }
+    }
+#endif
+    for (; from < to; ++from) {
+        result[from] = is_inner_convex(vertices, count, Vector(x[from], y[from]), vertex_reach);
+    }
+}
+
+struct Bounding_box {
+    explicit Bounding_box(const Prepared_polygon& polygon);
+
+    bool is_overlapping_by_y(const Bounding_box& other) const {
+        return min_y <= other.max_y && other.min_y <= max_y;
+    }
+
+    double min_x;
+    double max_x;
+    double min_y;
+    double max_y;
+};
+
+Bounding_box::Bounding_box(const Prepared_polygon& polygon)
+        : min_x(polygon[0].x)
+        , max_x(polygon[0].x)
+        , min_y(polygon[0].y)
+        , max_y(polygon[0].y) {
+    for (std::size_t i = 1; i < polygon.count(); ++i) {
+        min_x = std::min(min_x, polygon[i].x);
+        max_x = std::max(max_x, polygon[i].x);
+        min_y = std::min(min_y, polygon[i].y);
+        max_y = std::max(max_y, polygon[i].y);
+    }
+}
+
+//set of convex polygons which move between frames; broad phase is sweep and prune along x: boxes are kept sorted
+//by min_x, and since order changes little between frames, insertion sort restores it in almost linear time;
+//pairs of overlapping boxes are checked by is_intersection of prepared polygons in parallel threads
+class Collision_world {
+public:
+    using Pair = std::pair<uint32_t, uint32_t>;
+
+    uint32_t add(const Polygon& polygon); //returns id of polygon
+
+    void translate(uint32_t id, const Vector& shift);
+
+    void replace(uint32_t id, const Polygon& polygon);
+
+    const Prepared_polygon& operator[](uint32_t id) const {
+        return polygons[id];
+    }
+
+    std::size_t count() const {
+        return polygons.size();
+    }
+
+    //pairs of ids (less id first) of intersecting polygons, touching polygons intersect;
+    //candidates is the amount of pairs passed to the narrow phase
+    const std::vector<Pair>& find_intersecting_pairs(std::size_t* candidates = nullptr);
+
+private:
+    struct Sweep_entry {
+        Bounding_box box;
+        uint32_t id;
+    };
+
+    void update_sweep();
+
+    std::vector<Prepared_polygon> polygons;
+    std::vector<Sweep_entry> sweep;
+    std::vector<uint32_t> position_in_sweep;
+    std::vector<Pair> candidate_pairs;
+    std::vector<uint8_t> is_intersecting;
+    std::vector<Pair> intersecting_pairs;
+    std::size_t moved_far = 0; //added and replaced polygons since the last sweep
+};
+
+uint32_t Collision_world::add(const Polygon& polygon) {
+    uint32_t id = static_cast<uint32_t>(polygons.size());
+    polygons.emplace_back(polygon);
+    position_in_sweep.push_back(static_cast<uint32_t>(sweep.size()));
+    sweep.push_back({Bounding_box(polygons.back()), id});
+    ++moved_far;
+    return id;
+}
+
+void Collision_world::translate(uint32_t id, const Vector& shift) {
+    polygons[id].translate(shift);
+    Bounding_box& box = sweep[position_in_sweep[id]].box;
+    box.min_x += shift.x;
+    box.max_x += shift.x;
+    box.min_y += shift.y;
+    box.max_y += shift.y;
+}
+
+void Collision_world::replace(uint32_t id, const Polygon& polygon) {
+    polygons[id] = Prepared_polygon(polygon);
+    sweep[position_in_sweep[id]].box = Bounding_box(polygons[id]);
+    ++moved_far;
+}
+
+//insertion sort by min_x, positions of moved entries are updated; after many additions or replacements
+//order is built anew by full sort
+void Collision_world::update_sweep() {
+    if (moved_far > sweep.size() / 64) {
+        std::sort(sweep.begin(), sweep.end(), [](const Sweep_entry& first, const Sweep_entry& second) {
+            return first.box.min_x < second.box.min_x;
+        });
+        for (std::size_t i = 0; i < sweep.size(); ++i) position_in_sweep[sweep[i].id] = static_cast<uint32_t>(i);
+        moved_far = 0;
+        return;
+    }
+    moved_far = 0;
+    for (std::size_t i = 1; i < sweep.size(); ++i) {
+        if (sweep[i - 1].box.min_x <= sweep[i].box.min_x) continue;
+        Sweep_entry entry = sweep[i];
+        std::size_t j = i;
+        for (; j > 0 && sweep[j - 1].box.min_x > entry.box.min_x; --j) {
+            sweep[j] = sweep[j - 1];
+            position_in_sweep[sweep[j].id] = static_cast<uint32_t>(j);
+        }
+        sweep[j] = entry;
+        position_in_sweep[entry.id] = static_cast<uint32_t>(j);
+    }
+}
+
+constexpr std::size_t min_pairs_per_thread = 1 << 12;
+
+const std::vector<Collision_world::Pair>& Collision_world::find_intersecting_pairs(std::size_t* candidates) {
+    update_sweep();
+    candidate_pairs.clear();
+    for (std::size_t i = 0; i < sweep.size(); ++i) {
+        const Bounding_box& box = sweep[i].box;
+        for (std::size_t j = i + 1; j < sweep.size() && sweep[j].box.min_x <= box.max_x; ++j) {
+            if (box.is_overlapping_by_y(sweep[j].box))
+                candidate_pairs.emplace_back(std::min(sweep[i].id, sweep[j].id), std::max(sweep[i].id, sweep[j].id));
+        }
+    }
+    if (candidates) *candidates = candidate_pairs.size();
+
+    is_intersecting.resize(candidate_pairs.size());
+    geometry::parallel_for(candidate_pairs.size(), min_pairs_per_thread, [&](std::size_t from, std::size_t to) {
+        for (std::size_t i = from; i < to; ++i) {
+            is_intersecting[i] = is_intersection(polygons[candidate_pairs[i].first],
+                                                 polygons[candidate_pairs[i].second]);
+        }
+    });
+
+    intersecting_pairs.clear();
+    for (std::size_t i = 0; i < candidate_pairs.size(); ++i) {
+        if (is_intersecting[i]) intersecting_pairs.push_back(candidate_pairs[i]);
+    }
+    return intersecting_pairs;
+}
+
+//convex polygon with vertices on random ellipse, clockwise as in input
+Polygon random_convex_polygon(std::size_t n, const Vector& center, double radius, std::mt19937& generator) {
+    std::uniform_real_distribution<double> angle(0, 2 * M_PI);
+    std::uniform_real_distribution<double> stretch(0.3, 1);
+    std::vector<double> angles(n);
+    for (auto& a : angles) a = angle(generator);
+    std::sort(angles.begin(), angles.end(), std::greater<double>());
+    angles.erase(std::unique(angles.begin(), angles.end()), angles.end());
+
+    double rx = radius * stretch(generator);
+    double ry = radius * stretch(generator);
+    Polygon result;
+    for (auto a : angles) {
+        result.add_to_polygon(center + Vector(rx * cos(a), ry * sin(a)));
     }
-    else {
-        for (; i < first.count(); ++i) {
-            result.add_to_polygon(first[i] + second[j]);
-            if (j != 0 && is_less_polar_angle(second[0] - second[j], first[i + 1] - first[i])) {
-                j = 0;
-                --i;
+    return result;
+}
+
+//convex hull of random dots of integer lattice [-range, range]^2 shifted by center, clockwise as in input; some
+//lattice dots of its edges are added as vertices, so it has collinear vertices and exact touches
+Polygon random_lattice_polygon(std::size_t n, const Vector& center, int range, std::mt19937& generator) {
+    std::uniform_int_distribution<int> coordinate(-range, range);
+    std::vector<Vector> hull;
+    while (hull.size() < 3) {
+        std::vector<Vector> dots(n);
+        for (auto& d : dots) d = Vector(coordinate(generator), coordinate(generator));
+        std::sort(dots.begin(), dots.end(), [](const Vector& first, const Vector& second) {
+            return first.x < second.x || (first.x == second.x && first.y < second.y);
+        });
+        //monotone chain: lower part from left to right, then upper part back, clockwise without collinear vertices
+        hull.clear();
+        for (int part = 0; part < 2; ++part) {
+            std::size_t start = hull.size();
+            for (const Vector& d : dots) {
+                while (hull.size() >= start + 2 &&
+                       vector_product(hull.back() - hull[hull.size() - 2], d - hull.back()) >= 0) {
+                    hull.pop_back();
+                }
+                hull.push_back(d);
+            }
+            hull.pop_back();
+            std::reverse(dots.begin(), dots.end());
+        }
+    }
+
+    Polygon result;
+    for (std::size_t i = 0; i < hull.size(); ++i) {
+        Vector edge = hull[(i + 1) % hull.size()] - hull[i];
+        int steps = std::gcd(static_cast<int>(std::fabs(edge.x)), static_cast<int>(std::fabs(edge.y)));
+        for (int k = 0; k < steps; ++k) {
+            if (k == 0 || generator() % 2) {
+                result.add_to_polygon(center + hull[i] + Vector(edge.x / steps * k, edge.y / steps * k));
             }
         }
     }
     return result;
 }
 
-bool is_intersection(Polygon first, Polygon second) {
-    for (int i = 0; i < second.count(); ++i){
-        second[i] = (-1) * second[i];
+void benchmark_prepared() {
+    constexpr std::size_t polygons_amount = 40;
+    std::mt19937 generator(2020);
+    std::uniform_real_distribution<double> coordinate(-100, 100);
+    std::uniform_int_distribution<std::size_t> size(3, 80000);
+    std::vector<Polygon> polygons;
+    for (std::size_t i = 0; i < polygons_amount; ++i) {
+        polygons.push_back(random_convex_polygon(size(generator), Vector(coordinate(generator), coordinate(generator)),
+                                                 50, generator));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Prepared_polygon> prepared(polygons.begin(), polygons.end());
+    std::chrono::duration<double, std::milli> preparation = std::chrono::steady_clock::now() - start;
+
+    std::size_t intersections = 0;
+    std::size_t mismatches = 0;
+    start = std::chrono::steady_clock::now();
+    for (auto& first : prepared) {
+        for (auto& second : prepared) {
+            intersections += is_intersection(first, second);
+        }
+    }
+    std::chrono::duration<double, std::micro> fast = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < polygons_amount; ++i) {
+        for (std::size_t j = 0; j < polygons_amount; ++j) {
+            mismatches += (is_intersection(polygons[i], polygons[j]) != is_intersection(prepared[i], prepared[j]));
+        }
+    }
+    std::chrono::duration<double, std::micro> slow = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < polygons_amount; ++i) {
+        for (std::size_t j = 0; j < polygons_amount; ++j) {
+            mismatches += (is_intersection_in_place(polygons[i], polygons[j]) !=
+                           is_intersection(prepared[i], prepared[j]));
+        }
+    }
+    std::chrono::duration<double, std::micro> in_place = std::chrono::steady_clock::now() - start;
+
+    //small lattice polygons have collinear vertices and touch each other exactly
+    constexpr std::size_t lattice_tests = 100000;
+    std::uniform_int_distribution<int> shift(-6, 6);
+    std::uniform_int_distribution<std::size_t> lattice_size(3, 12);
+    std::size_t lattice_intersections = 0;
+    for (std::size_t k = 0; k < lattice_tests; ++k) {
+        Polygon first = random_lattice_polygon(lattice_size(generator), Vector(shift(generator), shift(generator)), 4,
+                                               generator);
+        Polygon second = random_lattice_polygon(lattice_size(generator), Vector(shift(generator), shift(generator)),
+                                                4, generator);
+        bool is_intersecting = is_intersection(first, second);
+        lattice_intersections += is_intersecting;
+        mismatches += (is_intersecting != is_intersection(Prepared_polygon(first), Prepared_polygon(second)));
+        mismatches += (is_intersecting != is_intersection_in_place(first, second));
+    }
+
+    std::size_t tests = polygons_amount * polygons_amount;
+    printf("preparation: %.1f ms for %zu polygons\nprepared test: %.3f us\nMinkowski sum test: %.1f us\n"
+           "in place test: %.1f us\nintersections: %zu of %zu, lattice intersections: %zu of %zu, mismatches: %zu\n",
+           preparation.count(), polygons_amount, fast.count() / tests, slow.count() / tests, in_place.count() / tests,
+           intersections, tests, lattice_intersections, lattice_tests, mismatches);
+}
+
+void benchmark_contains() {
+    constexpr std::size_t dots_amount = 1 << 23;
+    constexpr std::size_t linear_dots_amount = 1 << 10;
+    std::mt19937 generator(2020);
+    Polygon polygon = random_convex_polygon(1 << 16, Vector(0, 0), 100, generator);
+    Prepared_polygon prepared(polygon);
+    std::uniform_real_distribution<double> coordinate(-110, 110);
+    geometry::Vector_array<double, 2> dots;
+    dots.reserve(dots_amount);
+    for (std::size_t i = 0; i < dots_amount; ++i) {
+        //every fourth dot is a vertex, so border is checked as well
+        dots.push_back(i % 4 == 0 ? polygon[generator() % polygon.count()]
+                                  : Vector(coordinate(generator), coordinate(generator)));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::size_t linear_inside = 0;
+    std::size_t mismatches = 0;
+    for (std::size_t i = 0; i < linear_dots_amount; ++i) {
+        bool is_inside = polygon.is_inner(dots[i]);
+        linear_inside += is_inside;
+        mismatches += (is_inside != prepared.contains(dots[i]));
+    }
+    std::chrono::duration<double, std::nano> linear = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    std::vector<uint8_t> single(dots_amount);
+    for (std::size_t i = 0; i < dots_amount; ++i) single[i] = prepared.contains(dots[i]);
+    std::chrono::duration<double, std::nano> one_by_one = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    std::vector<uint8_t> batch;
+    prepared.contains(dots, batch);
+    std::chrono::duration<double, std::nano> batched = std::chrono::steady_clock::now() - start;
+
+    std::size_t inside = 0;
+    for (std::size_t i = 0; i < dots_amount; ++i) {
+        inside += batch[i];
+        mismatches += (single[i] != batch[i]);
+    }
+
+    //small lattice polygons have collinear vertices, and many dots of the lattice are on their borders
+    constexpr std::size_t lattice_polygons_amount = 20000;
+    constexpr int lattice_range = 5;
+    std::uniform_int_distribution<std::size_t> lattice_size(3, 12);
+    geometry::Vector_array<double, 2> lattice_dots;
+    for (int x = -lattice_range; x <= lattice_range; ++x) {
+        for (int y = -lattice_range; y <= lattice_range; ++y) lattice_dots.push_back(Vector(x, y));
+    }
+    for (std::size_t k = 0; k < lattice_polygons_amount; ++k) {
+        Polygon lattice = random_lattice_polygon(lattice_size(generator), Vector(0, 0), lattice_range - 1, generator);
+        Prepared_polygon prepared_lattice(lattice);
+        prepared_lattice.contains(lattice_dots, batch);
+        for (std::size_t i = 0; i < lattice_dots.size(); ++i) {
+            bool is_inside = lattice.is_inner(lattice_dots[i]);
+            mismatches += (is_inside != prepared_lattice.contains(lattice_dots[i])) + (is_inside != batch[i]);
+        }
     }
+
+    printf("polygon of %zu vertices, %zu dots, %u threads\nlinear is_inner: %.1f ns/dot\n"
+           "contains: %.1f ns/dot\nbatch contains: %.2f ns/dot\ninside: %zu, mismatches: %zu\n",
+           polygon.count(), dots_amount, std::thread::hardware_concurrency(), linear.count() / linear_dots_amount,
+           one_by_one.count() / dots_amount, batched.count() / dots_amount, inside, mismatches);
+}
+
+void benchmark_collisions() {
+    constexpr std::size_t polygons_amount = 100000;
+    constexpr std::size_t frames = 20;
+    constexpr double side = 2000;
+    std::mt19937 generator(2020);
+    std::uniform_real_distribution<double> coordinate(0, side);
+    std::uniform_real_distribution<double> speed(-0.5, 0.5);
+    std::uniform_int_distribution<std::size_t> size(3, 16);
+    Collision_world world;
+    std::vector<Vector> velocities;
+    for (std::size_t i = 0; i < polygons_amount; ++i) {
+        world.add(random_convex_polygon(size(generator), Vector(coordinate(generator), coordinate(generator)), 4,
+                                        generator));
+        velocities.push_back(Vector(speed(generator), speed(generator)));
+    }
+
+    std::size_t candidates = 0;
+    std::size_t pairs = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t frame = 0; frame < frames; ++frame) {
+        std::size_t frame_candidates;
+        pairs += world.find_intersecting_pairs(&frame_candidates).size();
+        candidates += frame_candidates;
+        for (uint32_t id = 0; id < polygons_amount; ++id) world.translate(id, velocities[id]);
+    }
+    std::chrono::duration<double, std::milli> total = std::chrono::steady_clock::now() - start;
+
+    printf("%zu polygons, %zu frames, %u threads: %.1f ms/frame\n"
+           "candidates: %zu/frame, intersecting pairs: %zu/frame\n",
+           polygons_amount, frames, std::thread::hardware_concurrency(), total.count() / frames,
+           candidates / frames, pairs / frames);
+}
+
+void benchmark_Minkowski_sum() {
+    constexpr std::size_t size = 1 << 20;
+    std::mt19937 generator(2020);
+    Polygon first = random_convex_polygon(size, Vector(0, 0), 100, generator);
+    Polygon second = random_convex_polygon(size, Vector(10, -20), 50, generator);
     first.orient();
     second.orient();
-    Polygon mink_sum = create_by_Minkowski_sum(first, second);
-    return mink_sum.is_inner(Vector(0, 0));
+
+    auto start = std::chrono::steady_clock::now();
+    Polygon serial = create_by_Minkowski_sum(first, second);
+    std::chrono::duration<double, std::milli> serial_time = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    Polygon parallel = create_by_Minkowski_sum_parallel(first, second);
+    std::chrono::duration<double, std::milli> parallel_time = std::chrono::steady_clock::now() - start;
+
+    std::size_t mismatches = (serial.count() != parallel.count());
+    for (std::size_t k = 0; k < std::min(serial.count(), parallel.count()); ++k) {
+        mismatches += (serial[k] != parallel[k]);
+    }
+    printf("%zu + %zu vertices, %u threads\nserial: %.1f ms\nparallel: %.1f ms\nmismatches: %zu\n",
+           first.count(), second.count(), std::thread::hardware_concurrency(), serial_time.count(),
+           parallel_time.count(), mismatches);
+}
+
+void benchmark_calipers() {
+    constexpr std::size_t size = 2000;
+    constexpr std::size_t polygons_amount = 2000;
+    constexpr std::size_t pairs_amount = 100000;
+    std::mt19937 generator(2020);
+    Polygon first = random_convex_polygon(size, Vector(0, 0), 100, generator);
+    Polygon second = random_convex_polygon(size, Vector(300, 50), 100, generator);
+
+    auto start = std::chrono::steady_clock::now();
+    Witnessed_distance distance = find_distance_between_polygons(first, second);
+    Witnessed_distance diameter = find_diameter(first);
+    Witnessed_distance width = find_width(first);
+    std::chrono::duration<double, std::micro> calipers = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    double brute_distance = std::numeric_limits<double>::infinity();
+    double brute_diameter = 0;
+    for (std::size_t i = 0; i < first.count(); ++i) {
+        for (std::size_t j = 0; j < second.count(); ++j) {
+            brute_distance = std::min(brute_distance, geometry::distance(first[i], second[j]));
+        }
+        for (std::size_t j = 0; j < first.count(); ++j) {
+            brute_diameter = std::max(brute_diameter, geometry::distance(first[i], first[j]));
+        }
+    }
+    std::chrono::duration<double, std::micro> brute = std::chrono::steady_clock::now() - start;
+
+    std::vector<Polygon> polygons;
+    std::uniform_real_distribution<double> coordinate(-1000, 1000);
+    std::uniform_int_distribution<std::size_t> polygon_size(3, 64);
+    for (std::size_t i = 0; i < polygons_amount; ++i) {
+        polygons.push_back(random_convex_polygon(polygon_size(generator),
+                                                 Vector(coordinate(generator), coordinate(generator)), 20, generator));
+    }
+    std::vector<std::pair<uint32_t, uint32_t>> pairs;
+    for (std::size_t k = 0; k < pairs_amount; ++k) {
+        pairs.emplace_back(generator() % polygons_amount, generator() % polygons_amount);
+    }
+    std::vector<Witnessed_distance> distances;
+    start = std::chrono::steady_clock::now();
+    find_distances_between_polygons(polygons, pairs, distances);
+    std::chrono::duration<double, std::nano> batch = std::chrono::steady_clock::now() - start;
+
+    //small lattice polygons have collinear vertices, so calipers meet parallel edges; width and diameter are
+    //compared with brute force over edges and pairs of vertices
+    constexpr std::size_t lattice_polygons_amount = 20000;
+    std::uniform_int_distribution<std::size_t> lattice_size(3, 12);
+    std::size_t mismatches = 0;
+    for (std::size_t k = 0; k < lattice_polygons_amount; ++k) {
+        Polygon lattice = random_lattice_polygon(lattice_size(generator), Vector(0, 0), 4, generator);
+        double lattice_diameter = 0;
+        double lattice_width = std::numeric_limits<double>::infinity();
+        for (std::size_t i = 0; i < lattice.count(); ++i) {
+            Vector direction = edge_of(lattice, i);
+            double farthest = 0;
+            for (std::size_t j = 0; j < lattice.count(); ++j) {
+                lattice_diameter = std::max(lattice_diameter, geometry::distance(lattice[i], lattice[j]));
+                farthest = std::max(farthest, std::fabs(vector_product(direction, Vector(lattice[i], lattice[j]))));
+            }
+            lattice_width = std::min(lattice_width, farthest / direction.length());
+        }
+        mismatches += (std::fabs(find_diameter(lattice).value - lattice_diameter) > 1e-9);
+        mismatches += (std::fabs(find_width(lattice).value - lattice_width) > 1e-9);
+    }
+
+    printf("polygons of %zu vertices\ndistance %.6f (vertices only: %.6f), diameter %.6f (%.6f), width %.6f\n"
+           "calipers: %.1f us, brute force over vertices: %.1f us\n"
+           "batch of %zu pairs, %u threads: %.1f ns/pair\nlattice polygons: %zu, mismatches: %zu\n", size,
+           distance.value, brute_distance, diameter.value, brute_diameter, width.value, calipers.count(),
+           brute.count(), pairs_amount, std::thread::hardware_concurrency(), batch.count() / pairs_amount,
+           lattice_polygons_amount, mismatches);
 }
 
-int main() {
+//usage: module3_solutionC [--bench-prepared | --bench-contains | --bench-collisions | --bench-minkowski |
+//                          --bench-calipers]
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--bench-calipers") {
+        benchmark_calipers();
+        return 0;
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-minkowski") {
+        benchmark_Minkowski_sum();
+        return 0;
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-collisions") {
+        benchmark_collisions();
+        return 0;
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-prepared") {
+        benchmark_prepared();
+        return 0;
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-contains") {
+        benchmark_contains();
+        return 0;
+    }
+
     int n;
     double d1, d2;
     Polygon first;
@@ -204,7 +1171,7 @@ int main() {
         std::cin >> d1 >> d2;
         second.add_to_polygon(Vector(d1, d2));
     }
-    std::string result = is_intersection(first, second) ? "YES" : "NO";
+    std::string result = is_intersection_in_place(first, second) ? "YES" : "NO";
     std::cout << result;
 
     return 0;
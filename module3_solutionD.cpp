@@ -17,108 +17,32 @@
 #include <vector>
 #include <cmath>
 #include <array>
-#include <set>
 #include <iterator>
+#include <cstdint>
+#include <thread>
+#include <tuple>
+#include <string>
+#include <random>
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include "geometry.h"
+#include "predicates.h"
 
-const double INF = 1e100; //constant for time in algorithm
-const double epsilon = 0.0001;
-
-double abs(double x) {
-    return (x > 0 ? x : -x);
-}
-
-struct Graph {
-    Graph() = default;
-    explicit Graph(size_t n) : vertices(std::vector<std::vector<size_t>>(n)) {}
-    void add_edge(size_t from, size_t to) {
-        vertices[from].push_back(to);
-        vertices[to].push_back(from);
-    }
-
-    size_t sum_of_vertices_degrees() {
-        size_t result = 0;
-        for (auto& v: vertices) {
-            result += v.size();
-        }
-        return result;
-    }
-
-    void delete_vertex(size_t v) { vertices[v].assign(0, 0); }
-    std::vector<std::vector<size_t>> vertices;
-};
-
-struct Vector {
-    Vector() = default;
-    explicit Vector(double _x, double _y, double _z) :  x(_x), y(_y), z(_z) {}
-    explicit Vector(const Vector& start, const Vector& end) {
-        x = end.x - start.x;
-        y = end.y - start.y;
-        z = end.z - start.z;
-    }
-
-    double length() const {
-        return sqrt(x*x + y*y + z*z);
-    }
-
-    friend double scalar_product(const Vector& first, const Vector& second) {
-        return first.x * second.x + first.y * second.y + first.z * second.z;
-    }
+using Vector = geometry::Vector<double, 3>;
 
-    friend Vector proection(const Vector& base, const Vector& to_be_proected) {
-        Vector result;
-        double coef = scalar_product(base, to_be_proected) / base.length();
-        result.x = base.x / abs(base.x) * coef;
-        result.y = base.y / abs(base.y) * coef;
-        result.z = base.z / abs(base.z) * coef;
-        return result;
-    }
-
-    friend Vector operator+(const Vector& first, const Vector& second) {
-        Vector result;
-        result.x = first.x + second.x;
-        result.y = first.y + second.y;
-        result.z = first.z + second.z;
-        return result;
-    }
-
-    friend Vector operator-(const Vector& first, const Vector& second) {
-        Vector result;
-        result.x = first.x - second.x;
-        result.y = first.y - second.y;
-        result.z = first.z - second.z;
-        return result;
-    }
-
-    friend Vector operator*(double number, const Vector& vect) {
-        Vector result(vect);
-        result.x  *= number;
-        result.y  *= number;
-        result.z  *= number;
-        return result;
-    }
-
-    double x;
-    double y;
-    double z;
-};
-
-double distance(const Vector& first, const Vector& second) {
-    double result = sqrt((first.x - second.x) * (first.x - second.x)
-                         + (first.y - second.y) * (first.y - second.y)
-                         + (first.z - second.z) * (first.z - second.z));
-    return result;
-}
+const double INF = 1e100; //constant for time in algorithm
 
 struct Tetrad {
     Tetrad() = default;
-    explicit Tetrad(size_t _first) : first(_first)
-                                   , second(0)
-                                   , third(0)
-                                   , fourth(0) {}
-    size_t first;
-    size_t second;
-    size_t third;
-    size_t fourth;
+    explicit Tetrad(uint32_t _first) : first(_first)
+                                     , second(0)
+                                     , third(0)
+                                     , fourth(0) {}
+    uint32_t first;
+    uint32_t second;
+    uint32_t third;
+    uint32_t fourth;
 
     void print() {
         std::cout << first << " " << second << " " << third << " " << fourth << "\n";
@@ -126,7 +50,7 @@ struct Tetrad {
 
     void organize() {
         char min = 1;
-        size_t tmp = second;
+        uint32_t tmp = second;
         if (tmp > third) { tmp = third; min = 2; }
         if (tmp > fourth) min = 3;
 
@@ -155,101 +79,183 @@ struct Tetrad {
         else if (first.second == second.second && first.third < second.third) return true;
         else return (first.second == second.second && first.third == second.third && first.fourth < second.fourth);
     }
+
+    bool friend operator==(const Tetrad& first, const Tetrad& second) {
+        return first.second == second.second && first.third == second.third && first.fourth == second.fourth;
+    }
 };
 
-struct Dot { //it is a vector with some additional information and function
+//stable LSD radix sort by key(value) < 2^key_bits, 8 bits per pass; buffer is reused between calls
+template <class T, class Key>
+void radix_sort(std::vector<T>& values, std::vector<T>& buffer, Key key, unsigned key_bits) {
+    buffer.resize(values.size());
+    for (unsigned shift = 0; shift < key_bits; shift += 8) {
+        std::array<size_t, 257> counts{};
+        for (const auto& value : values) ++counts[((key(value) >> shift) & 255) + 1];
+        for (size_t k = 1; k < counts.size(); ++k) counts[k] += counts[k - 1];
+        for (const auto& value : values) buffer[counts[(key(value) >> shift) & 255]++] = value;
+        values.swap(buffer);
+    }
+}
+
+unsigned bits_for(uint64_t max_value) { //bits enough for numbers up to max_value
+    unsigned bits = 1;
+    while (bits < 64 && (max_value >> bits) != 0) ++bits;
+    return bits;
+}
+
+struct Dot { //dot of input with its number, hull is built by Kinetic_hull on indices of sorted dots
     Dot() = default;
     Dot(double _x, double _y, double _z, size_t num) : current(Vector(_x, _y, _z))
-                                         , prev(nullptr)
-                                         , next(nullptr)
                                          , number(num) { }
-    Vector current; //three dots define a face
-    Dot* prev;
-    Dot* next;
+    Vector current;
     size_t number;
-    bool insert_if_possible();
-    friend bool operator<(const Dot& first, const Dot& second) { return first.current.x < second.current.x; }
-    void turn_around_zero(double angle);
+    friend bool operator<(const Dot& first, const Dot& second) { //equal x are ordered by number, so order
+                                                                  //does not depend on sort algorithm
+        return first.current.x < second.current.x ||
+               (first.current.x == second.current.x && first.number < second.number);
+    }
 };
 
-void Dot::turn_around_zero(double angle) {
-    double tmp_x, tmp_y, tmp_z;
-    tmp_z = current.z * cos(angle) + current.y * sin(angle); //around Ox
-    tmp_y = -current.z * sin(angle) + current.y * cos(angle);
-    current.z = tmp_z;
-    current.y = tmp_y;
-
-    tmp_x = current.x * cos(angle) + current.z * sin(angle); //around Oy
-    tmp_z = -current.x * sin(angle) + current.z * cos(angle);
-    current.x = tmp_x;
-    current.z = tmp_z;
-
-    tmp_x = current.x * cos(angle) + current.y * sin(angle); //around Oz
-    tmp_y = -current.x * sin(angle) + current.y * cos(angle);
-    current.x = tmp_x;
-    current.y = tmp_y;
-}
-
-bool Dot::insert_if_possible() { //in sequence of 2D events this function inserts *this dot in hull or delete
-                                 //depends on the situation; returns true if inserted
-    if (prev->next != this) { //insert
-        prev->next = this;
-        next->prev = this;
+constexpr uint32_t no_dot = UINT32_MAX;
+
+//dots sorted by x are 32-bit indices into array of compact records, so index order is x order; prev and next
+//link dots of the current 2D hull. Events of every part of recursion are written to a slice of one of two buffers:
+//part [start, start + num) of depth d owns [2 * start, 2 * (start + num)) of buffer d % 2, since every dot
+//is inserted and deleted at most once; children are read from the other buffer while parent writes
+class Kinetic_hull {
+public:
+    explicit Kinetic_hull(const std::vector<Dot>& sorted_dots);
+
+    size_t size() const {
+        return dots.size();
+    }
+
+    //builds lower hull of all dots, returns events of the whole set
+    std::pair<const uint32_t*, size_t> build(size_t forks_depth = 0, size_t cutoff = 0);
+
+    bool insert_if_possible(uint32_t dot); //in sequence of 2D events this function inserts dot in hull or delete
+                                           //depends on the situation; returns true if inserted
+
+    uint32_t prev_of(uint32_t dot) const { return dots[dot].prev; }
+    uint32_t next_of(uint32_t dot) const { return dots[dot].next; }
+    size_t number_of(uint32_t dot) const { return number[dot]; }
+
+    size_t arena_bytes() const {
+        return (events[0].capacity() + events[1].capacity()) * sizeof(uint32_t);
+    }
+
+private:
+    double sign_of_turn(uint32_t p, uint32_t q, uint32_t r) const;
+    double time(uint32_t p, uint32_t q, uint32_t r) const;
+    size_t build(uint32_t start, uint32_t num, size_t depth, size_t forks_depth, size_t cutoff);
+
+    struct Kinetic_dot { //32 bytes: coordinates and links of a dot, which are read together, share a cache line
+        Vector current;
+        uint32_t prev;
+        uint32_t next;
+    };
+
+    std::vector<Kinetic_dot> dots;
+    std::vector<uint32_t> number; //number of dot in input, only for the answer
+    std::vector<uint32_t> events[2];
+};
+
+Kinetic_hull::Kinetic_hull(const std::vector<Dot>& sorted_dots)
+        : dots(sorted_dots.size())
+        , number(sorted_dots.size()) {
+    for (size_t i = 0; i < sorted_dots.size(); ++i) {
+        dots[i] = {sorted_dots[i].current, no_dot, no_dot};
+        number[i] = static_cast<uint32_t>(sorted_dots[i].number);
+    }
+    events[0].resize(2 * sorted_dots.size());
+    events[1].resize(2 * sorted_dots.size());
+}
+
+bool Kinetic_hull::insert_if_possible(uint32_t dot) {
+    if (dots[dots[dot].prev].next != dot) { //insert
+        dots[dots[dot].prev].next = dot;
+        dots[dots[dot].next].prev = dot;
         return true;
     }
     else { //delete
-        prev->next = next;
-        next->prev = prev;
+        dots[dots[dot].prev].next = dots[dot].next;
+        dots[dots[dot].next].prev = dots[dot].prev;
         return false;
     }
 }
 
-double sign_of_turn(Dot* p, Dot* q, Dot* r) { //Y-component of vector product [pq, pr]
-    if (p == nullptr || q == nullptr || r == nullptr)
+double Kinetic_hull::sign_of_turn(uint32_t p, uint32_t q, uint32_t r) const { //Y-component of vector product
+                                                                             //[pq, pr]
+    if (p == no_dot || q == no_dot || r == no_dot)
         return 1;
 
-    return (q->current.x - p->current.x) * (r->current.y - p->current.y)
-           - (r->current.x - p->current.x) * (q->current.y - p->current.y);
+    const Vector& a = dots[p].current;
+    const Vector& b = dots[q].current;
+    const Vector& c = dots[r].current;
+    return geometry::orient2d(geometry::Vector2d(a.x, a.y), geometry::Vector2d(b.x, b.y),
+                              geometry::Vector2d(c.x, c.y));
 }
 
-double time(Dot* p, Dot* q, Dot* r) { //return time when sign of turn changes <-> vectors pq, pr collinear
-    if (p == nullptr || q == nullptr || r == nullptr)
+double Kinetic_hull::time(uint32_t p, uint32_t q, uint32_t r) const { //return time when sign of turn changes <->
+                                                                     //vectors pq, pr collinear
+    if (p == no_dot || q == no_dot || r == no_dot)
         return INF;
 
-    return ((q->current.x - p->current.x) * (r->current.z - p->current.z)
-           - (r->current.x - p->current.x) * (q->current.z - p->current.z))
-           / sign_of_turn(p, q, r);
+    const Vector& a = dots[p].current;
+    const Vector& b = dots[q].current;
+    const Vector& c = dots[r].current;
+    return geometry::orient2d(geometry::Vector2d(a.x, a.z), geometry::Vector2d(b.x, b.z),
+                              geometry::Vector2d(c.x, c.z)) / sign_of_turn(p, q, r);
+}
+
+std::pair<const uint32_t*, size_t> Kinetic_hull::build(size_t forks_depth, size_t cutoff) {
+    if (size() == 0) return {events[0].data(), 0};
+    return {events[0].data(), build(0, static_cast<uint32_t>(size()), 0, forks_depth, cutoff)};
 }
 
 //in that part we go form 3D to 2D, so Dots becomes Events
 //there are two types of Events - insertion and deletion
-std::vector<Dot*> _build_lower_part_of_convex_hull(const std::vector<Dot>::iterator& start_list_of_events
-        ,const std::vector<Dot>::iterator& end_list_of_events, size_t num) {
-    Dot* u;
-    Dot* v; //dots of bridge
+//halves use disjoint dots and slices until the merge, so while forks_depth > 0 and num >= cutoff the left half
+//is built in a new thread
+size_t Kinetic_hull::build(uint32_t start, uint32_t num, size_t depth, size_t forks_depth, size_t cutoff) {
+    uint32_t u;
+    uint32_t v; //dots of bridge
     std::array<double, 6> times = {INF, INF, INF, INF, INF, INF};
     double cur_time;
     size_t index_of_cur_time = 0;
     double prev_time = -INF;
 
-    if (start_list_of_events + 1 == end_list_of_events) {
-        return std::vector<Dot*>();
+    if (num == 1) {
+        return 0;
     }
 
-    auto middle = start_list_of_events + (num / 2); //divide
-    std::vector<Dot*> left_part = _build_lower_part_of_convex_hull(start_list_of_events,
-            middle, num / 2);
-    std::vector<Dot*> right_part = _build_lower_part_of_convex_hull(middle,
-            end_list_of_events, num - (num / 2));
-    std::vector<Dot*> result;
+    uint32_t middle = start + num / 2; //divide
+    const uint32_t* left_part = events[(depth + 1) % 2].data() + 2 * size_t(start);
+    const uint32_t* right_part = events[(depth + 1) % 2].data() + 2 * size_t(middle);
+    size_t left_size;
+    size_t right_size;
+    if (forks_depth > 0 && num >= cutoff) {
+        std::thread left_thread([&]() {
+            left_size = build(start, num / 2, depth + 1, forks_depth - 1, cutoff);
+        });
+        right_size = build(middle, num - num / 2, depth + 1, forks_depth - 1, cutoff);
+        left_thread.join();
+    }
+    else {
+        left_size = build(start, num / 2, depth + 1, 0, cutoff);
+        right_size = build(middle, num - num / 2, depth + 1, 0, cutoff);
+    }
+    uint32_t* result = events[depth % 2].data() + 2 * size_t(start);
+    size_t result_size = 0;
 
-    u = &(*(middle - 1));
-    v = &(*middle);
+    u = middle - 1;
+    v = middle;
     while (true) { //find bridge
-        if (sign_of_turn(u, v, v->next) < 0)
-            v = v->next;
-        else if (sign_of_turn(u->prev, u, v) < 0)
-            u = u->prev;
+        if (sign_of_turn(u, v, dots[v].next) < 0)
+            v = dots[v].next;
+        else if (sign_of_turn(dots[u].prev, u, v) < 0)
+            u = dots[u].prev;
         else
             break;
     }
@@ -258,16 +264,16 @@ std::vector<Dot*> _build_lower_part_of_convex_hull(const std::vector<Dot>::itera
     size_t j = 0; //counters
     while (true) {
         //count times
-        if (i < left_part.size()) {
-            times[0] = time(left_part[i]->prev, left_part[i], left_part[i]->next); //appearance or disappearance
+        if (i < left_size) {
+            times[0] = time(dots[left_part[i]].prev, left_part[i], dots[left_part[i]].next); //appearance or disappearance
         }
-        if (j < right_part.size()) {
-            times[1] = time(right_part[j]->prev, right_part[j], right_part[j]->next);
+        if (j < right_size) {
+            times[1] = time(dots[right_part[j]].prev, right_part[j], dots[right_part[j]].next);
         }
-        times[2] = time(u, u->next, v); //overbuilding of bridge
-        times[3] = time(u->prev, u, v);
-        times[4] = time(u, v->prev, v);
-        times[5] = time(u, v, v->next);
+        times[2] = time(u, dots[u].next, v); //overbuilding of bridge
+        times[3] = time(dots[u].prev, u, v);
+        times[4] = time(u, dots[v].prev, v);
+        times[5] = time(u, v, dots[v].next);
 
         cur_time = INF;
         for(size_t k = 0; k < 6; ++k) {
@@ -281,75 +287,79 @@ std::vector<Dot*> _build_lower_part_of_convex_hull(const std::vector<Dot>::itera
 
         switch (index_of_cur_time) {
             case 0:
-                if (left_part[i]->current.x < u->current.x) {
-                    result.push_back(left_part[i]);
+                if (left_part[i] < u) {
+                    result[result_size++] = left_part[i];
                 }
-                left_part[i]->insert_if_possible();
+                insert_if_possible(left_part[i]);
                 ++i;
                 break;
             case 1:
-                if (right_part[j]->current.x > v->current.x) {
-                    result.push_back(right_part[j]);
+                if (right_part[j] > v) {
+                    result[result_size++] = right_part[j];
                 }
-                right_part[j]->insert_if_possible();
+                insert_if_possible(right_part[j]);
                 ++j;
                 break;
             case 2:
-                u = u->next;
-                result.push_back(u);
+                u = dots[u].next;
+                result[result_size++] = u;
                 break;
             case 3:
-                result.push_back(u);
-                u = u->prev;
+                result[result_size++] = u;
+                u = dots[u].prev;
                 break;
             case 4:
-                v = v->prev;
-                result.push_back(v);
+                v = dots[v].prev;
+                result[result_size++] = v;
                 break;
             case 5:
-                result.push_back(v);
-                v = v->next;
+                result[result_size++] = v;
+                v = dots[v].next;
                 break;
             default:
                 break;
         }
     }
 
-    u->next = v;
-    v->prev = u;
-    for (int32_t k = result.size() - 1; k >= 0; --k) { //restore sequence of events
-        if (result[k]->current.x <= u->current.x || result[k]->current.x >= v->current.x) {
-            result[k]->insert_if_possible();
-            if (result[k] == v) {
-                v = v->next;
+    dots[u].next = v;
+    dots[v].prev = u;
+    for (size_t k = result_size; k-- > 0;) { //restore sequence of events
+        uint32_t event = result[k];
+        if (event <= u || event >= v) {
+            insert_if_possible(event);
+            if (event == v) {
+                v = dots[v].next;
             }
-            else if (result[k] == u) {
-                u = u->prev;
+            else if (event == u) {
+                u = dots[u].prev;
             }
         }
         else {
-            result[k]->prev = u;
-            result[k]->next = v;
-            u->next = result[k];
-            v->prev = result[k];
-            if (result[k]->current.x > (*(middle-1)).current.x) {
-                v = result[k];
+            dots[event].prev = u;
+            dots[event].next = v;
+            dots[u].next = event;
+            dots[v].prev = event;
+            if (event > middle - 1) {
+                v = event;
             } else {
-                u = result[k];
+                u = event;
             }
         }
     }
-    return result;
+    return result_size;
 }
 
-void write_answer(const std::vector<Dot*>& from, std::set<Tetrad>& to, bool is_lower) {
+void write_answer(Kinetic_hull& hull, const std::pair<const uint32_t*, size_t>& from, std::vector<Tetrad>& to,
+        bool is_lower) {
     Tetrad tmp(3);
     bool flag;
-    for (auto& e : from) {
-        tmp.second = e->prev->number;
-        tmp.third = e->number;
-        tmp.fourth = e->next->number;
-        flag = e->insert_if_possible();
+    to.reserve(to.size() + from.second);
+    for (size_t k = 0; k < from.second; ++k) {
+        uint32_t e = from.first[k];
+        tmp.second = hull.number_of(hull.prev_of(e));
+        tmp.third = hull.number_of(e);
+        tmp.fourth = hull.number_of(hull.next_of(e));
+        flag = hull.insert_if_possible(e);
         if (is_lower) {
             flag = !flag;
         }
@@ -357,82 +367,1629 @@ void write_answer(const std::vector<Dot*>& from, std::set<Tetrad>& to, bool is_l
             std::swap(tmp.second, tmp.third);
         }
         tmp.organize();
-        to.insert(tmp);
+        to.push_back(tmp);
     }
 }
 
+//triangles are sorted by vertices as std::set<Tetrad> would keep them, repeated ones are removed
+void sort_and_deduplicate(std::vector<Tetrad>& triangles, size_t number_of_dots) {
+    std::vector<Tetrad> buffer;
+    unsigned bits = bits_for(number_of_dots);
+    radix_sort(triangles, buffer, [](const Tetrad& t) { return uint64_t(t.fourth); }, bits);
+    radix_sort(triangles, buffer, [](const Tetrad& t) { return uint64_t(t.third); }, bits);
+    radix_sort(triangles, buffer, [](const Tetrad& t) { return uint64_t(t.second); }, bits);
+    triangles.erase(std::unique(triangles.begin(), triangles.end()), triangles.end());
+}
+
 double project_onto_paraboloid(double x, double y) {
     return (x * x + y * y);
 }
 
-struct Side { //side of triangle from triangulation, side (u, v) == (v, u)
-    Side() = default;
-    Side(size_t _f, size_t _s) {
-        if (_f < _s) {
-            first = _f;
-            second = _s;
+//side (u, v) == (v, u) of triangle is a key with the less vertex in the high bits; keys are sorted, and a key
+//met twice is an inner side, once - a side of hull. Returns sum of degrees of dots, which are not on hull,
+//and the amount of hull sides
+std::pair<size_t, size_t> count_inner_Voronoi_diagram_sides(const std::vector<Tetrad>& triangulation
+        , size_t number_of_dots) {
+    const unsigned bits = bits_for(number_of_dots);
+    auto side = [bits](uint32_t u, uint32_t v) {
+        return (uint64_t(std::min(u, v)) << bits) | std::max(u, v);
+    };
+    std::vector<uint64_t> sides;
+    sides.reserve(3 * triangulation.size());
+    for (const auto& t : triangulation) {
+        sides.push_back(side(t.second, t.third));
+        sides.push_back(side(t.fourth, t.third));
+        sides.push_back(side(t.fourth, t.second));
+    }
+    std::vector<uint64_t> buffer;
+    radix_sort(sides, buffer, [](uint64_t key) { return key; }, 2 * bits);
+    buffer = std::vector<uint64_t>();
+
+    const uint64_t mask = (uint64_t(1) << bits) - 1;
+    std::vector<uint32_t> degrees(number_of_dots, 0);
+    std::vector<uint8_t> is_on_hull(number_of_dots, 0);
+    size_t out_sides = 0;
+    for (size_t k = 0; k < sides.size();) {
+        size_t end = k + 1;
+        while (end < sides.size() && sides[end] == sides[k]) ++end;
+        uint32_t u = static_cast<uint32_t>(sides[k] >> bits);
+        uint32_t v = static_cast<uint32_t>(sides[k] & mask);
+        if (end - k == 1) { //iff side is inner, we meet it twice
+            is_on_hull[u] = is_on_hull[v] = 1;
+            ++out_sides;
         }
         else {
-            first = _s;
-            second = _f;
+            ++degrees[u];
+            ++degrees[v];
+        }
+        k = end;
+    }
+
+    size_t sum_of_degrees = 0;
+    for (size_t v = 0; v < number_of_dots; ++v) {
+        if (!is_on_hull[v]) sum_of_degrees += degrees[v];
+    }
+    return std::make_pair(sum_of_degrees, out_sides);
+}
+
+//least amount of dots in a part which is built in its own thread
+constexpr size_t default_parallel_cutoff = 1 << 14;
+
+size_t forks_depth_for(size_t threads_amount) { //two forks per thread for balance
+    size_t depth = 0;
+    while ((size_t(1) << depth) < 2 * threads_amount) ++depth;
+    return (threads_amount > 1 ? depth : 0);
+}
+
+//dots are sorted by parts in threads, then sorted parts are merged pairwise in parallel
+void sort_in_parallel(std::vector<Dot>& dots, size_t threads_amount, size_t cutoff) {
+    size_t parts = std::max<size_t>(1, std::min(threads_amount, dots.size() / std::max<size_t>(cutoff, 1)));
+    std::vector<size_t> bounds;
+    for (size_t k = 0; k <= parts; ++k) bounds.push_back(dots.size() * k / parts);
+
+    std::vector<std::thread> threads;
+    for (size_t k = 0; k + 1 < bounds.size(); ++k) {
+        threads.emplace_back([&dots, &bounds, k]() {
+            std::sort(dots.begin() + bounds[k], dots.begin() + bounds[k + 1]);
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    for (size_t width = 1; width < parts; width *= 2) {
+        threads.clear();
+        for (size_t k = 0; k + width < parts; k += 2 * width) {
+            threads.emplace_back([&dots, &bounds, k, width, parts]() {
+                std::inplace_merge(dots.begin() + bounds[k], dots.begin() + bounds[k + width],
+                                   dots.begin() + bounds[std::min(k + 2 * width, parts)]);
+            });
+        }
+        for (auto& thread : threads) thread.join();
+    }
+}
+
+//triangulation is the lower part of convex hull of dots lifted onto paraboloid
+std::vector<Tetrad> find_Delaunay_triangulation(std::vector<Dot> dots, size_t threads_amount = 1,
+        size_t cutoff = default_parallel_cutoff) {
+    std::vector<Tetrad> triangulation;
+    const size_t number_of_dots = dots.size();
+    sort_in_parallel(dots, threads_amount, cutoff);
+
+    Kinetic_hull hull(dots);
+    dots = std::vector<Dot>(); //only coordinate arrays of hull are used further
+    auto events = hull.build(forks_depth_for(threads_amount), cutoff);
+    write_answer(hull, events, triangulation, true);
+    sort_and_deduplicate(triangulation, number_of_dots);
+    return triangulation;
+}
+
+using Point = geometry::Vector<double, 2>;
+
+double orientation(const Point& a, const Point& b, const Point& c) { //> 0 if a, b, c go counterclockwise
+    return geometry::orient2d(a, b, c);
+}
+
+double in_circle(const Point& a, const Point& b, const Point& c, const Point& d) { //> 0 if d is inside circle
+                                                                                   //of counterclockwise a, b, c
+    return geometry::incircle(a, b, c, d);
+}
+
+//convex hull of dots in 3D by quickhull: every face keeps dots which are outside of it, the farthest of them is
+//added to hull, faces seen from it are removed and sides of horizon are connected to it. Orientations are exact,
+//so dots in the plane of a face are not outside of it, and coplanar faces of hull are triangulated without gaps
+class Quickhull {
+public:
+    explicit Quickhull(const std::vector<Dot>& dots);
+    std::vector<Tetrad> faces() const; //vertices go counterclockwise if we look from outside
+
+private:
+    struct Face {
+        uint32_t vertices[3];
+        uint32_t neighbours[3]; //neighbours[k] is behind side vertices[k] -> vertices[(k + 1) % 3]
+        std::vector<uint32_t> outside;
+        uint32_t visit; //number of the last search which has found face seen
+        bool is_removed;
+    };
+
+    std::vector<Vector> points;
+    std::vector<uint32_t> numbers; //numbers of dots in input
+    std::vector<Face> hull;
+    std::vector<uint32_t> free_faces; //removed faces, which are reused
+    std::vector<uint32_t> new_face_from; //new face whose side of horizon starts at dot
+    uint32_t visits = 0;
+
+    double orient(uint32_t face, uint32_t dot) const { //< 0 iff dot is outside of face
+        const Face& f = hull[face];
+        return geometry::orient3d(points[f.vertices[0]], points[f.vertices[1]], points[f.vertices[2]],
+                                  points[dot]);
+    }
+    bool is_collinear(uint32_t a, uint32_t b, uint32_t c) const;
+    uint32_t add_face(uint32_t a, uint32_t b, uint32_t c);
+    void link(uint32_t face, uint32_t k, uint32_t neighbour);
+    void assign(const std::vector<uint32_t>& dots, const std::vector<uint32_t>& faces);
+    void build_flat(uint32_t a, uint32_t b, uint32_t c);
+    void build(uint32_t a, uint32_t b, uint32_t c, uint32_t d);
+    void add_dot(uint32_t face, std::vector<uint32_t>& pending);
+};
+
+Quickhull::Quickhull(const std::vector<Dot>& dots) : new_face_from(dots.size(), no_dot) {
+    for (const auto& d : dots) {
+        points.push_back(d.current);
+        numbers.push_back(static_cast<uint32_t>(d.number));
+    }
+    auto is_less = [this](uint32_t i, uint32_t j) {
+        return std::tie(points[i].x, points[i].y, points[i].z) < std::tie(points[j].x, points[j].y, points[j].z);
+    };
+    uint32_t a = 0, b = 0; //the least and the greatest dots differ if not all dots are equal
+    for (uint32_t i = 0; i < points.size(); ++i) {
+        if (is_less(i, a)) a = i;
+        if (is_less(b, i)) b = i;
+    }
+    if (points.empty() || !is_less(a, b)) return;
+
+    uint32_t c = no_dot; //the farthest from line ab
+    double farthest = 0;
+    for (uint32_t i = 0; i < points.size(); ++i) {
+        double distance = vector_product(points[b] - points[a], points[i] - points[a]).squared_length();
+        if ((c == no_dot || distance > farthest) && !is_collinear(a, b, i)) {
+            c = i;
+            farthest = distance;
+        }
+    }
+    if (c == no_dot) return; //all dots are on one line
+
+    uint32_t d = no_dot; //the farthest from plane abc
+    farthest = 0;
+    for (uint32_t i = 0; i < points.size(); ++i) {
+        double distance = std::fabs(geometry::orient3d(points[a], points[b], points[c], points[i]));
+        if (distance > farthest) {
+            d = i;
+            farthest = distance;
+        }
+    }
+    if (d == no_dot) build_flat(a, b, c);
+    else build(a, b, c, d);
+}
+
+//a, b, c are on one line iff their projections onto all coordinate planes are
+bool Quickhull::is_collinear(uint32_t a, uint32_t b, uint32_t c) const {
+    for (size_t k = 0; k < 3; ++k) {
+        auto projection = [this, k](uint32_t dot) {
+            return Point(points[dot][k], points[dot][(k + 1) % 3]);
+        };
+        if (orientation(projection(a), projection(b), projection(c)) != 0) return false;
+    }
+    return true;
+}
+
+uint32_t Quickhull::add_face(uint32_t a, uint32_t b, uint32_t c) {
+    uint32_t face;
+    if (free_faces.empty()) {
+        face = static_cast<uint32_t>(hull.size());
+        hull.emplace_back();
+    }
+    else {
+        face = free_faces.back();
+        free_faces.pop_back();
+    }
+    Face& f = hull[face];
+    f.vertices[0] = a, f.vertices[1] = b, f.vertices[2] = c;
+    f.neighbours[0] = f.neighbours[1] = f.neighbours[2] = no_dot;
+    f.outside.clear();
+    f.visit = 0;
+    f.is_removed = false;
+    return face;
+}
+
+//neighbour gets face behind its side, which is side k of face in the opposite direction
+void Quickhull::link(uint32_t face, uint32_t k, uint32_t neighbour) {
+    hull[face].neighbours[k] = neighbour;
+    Face& n = hull[neighbour];
+    for (size_t j = 0; j < 3; ++j) {
+        if (n.vertices[j] == hull[face].vertices[(k + 1) % 3]) n.neighbours[j] = face;
+    }
+}
+
+//every dot goes to the first face which it is outside of, dots which are outside of no face are inside of hull
+void Quickhull::assign(const std::vector<uint32_t>& dots, const std::vector<uint32_t>& faces) {
+    for (uint32_t dot : dots) {
+        for (uint32_t face : faces) {
+            if (orient(face, dot) < 0) {
+                hull[face].outside.push_back(dot);
+                break;
+            }
+        }
+    }
+}
+
+//all dots are in plane abc: hull is convex polygon, it is built on the coordinate plane where abc is not
+//degenerate. Its front is a fan of triangles from one vertex, its back is a fan from the next vertex with
+//the opposite orientation, so inner sides of the two fans differ and the surface is closed
+void Quickhull::build_flat(uint32_t a, uint32_t b, uint32_t c) {
+    size_t axis = 0;
+    auto projection = [this, &axis](uint32_t dot) {
+        return Point(points[dot][axis], points[dot][(axis + 1) % 3]);
+    };
+    while (orientation(projection(a), projection(b), projection(c)) == 0) ++axis;
+
+    std::vector<uint32_t> order(points.size());
+    for (uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&projection](uint32_t i, uint32_t j) {
+        Point p = projection(i), q = projection(j);
+        return p.x < q.x || (p.x == q.x && p.y < q.y);
+    });
+    std::vector<uint32_t> polygon; //Andrew's monotone chain: lower part, then upper part
+    for (size_t pass = 0; pass < 2; ++pass) {
+        const size_t start = polygon.size();
+        for (uint32_t dot : order) {
+            while (polygon.size() >= start + 2 && orientation(projection(polygon[polygon.size() - 2]),
+                    projection(polygon.back()), projection(dot)) <= 0) {
+                polygon.pop_back();
+            }
+            polygon.push_back(dot);
+        }
+        polygon.pop_back(); //it is the first dot of the other part
+        std::reverse(order.begin(), order.end());
+    }
+    for (size_t k = 1; k + 1 < polygon.size(); ++k) add_face(polygon[0], polygon[k], polygon[k + 1]);
+    for (size_t k = 2; k < polygon.size(); ++k) add_face(polygon[1], polygon[(k + 1) % polygon.size()], polygon[k]);
+}
+
+void Quickhull::build(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+    if (geometry::orient3d(points[a], points[b], points[c], points[d]) < 0) std::swap(b, c);
+    std::vector<uint32_t> simplex = {add_face(a, b, c), add_face(b, a, d), add_face(c, b, d), add_face(a, c, d)};
+    link(simplex[0], 0, simplex[1]);
+    link(simplex[0], 1, simplex[2]);
+    link(simplex[0], 2, simplex[3]);
+    link(simplex[1], 2, simplex[2]);
+    link(simplex[2], 2, simplex[3]);
+    link(simplex[3], 2, simplex[1]);
+
+    std::vector<uint32_t> dots;
+    for (uint32_t i = 0; i < points.size(); ++i) {
+        if (i != a && i != b && i != c && i != d) dots.push_back(i);
+    }
+    assign(dots, simplex);
+    std::vector<uint32_t> pending = simplex;
+    while (!pending.empty()) {
+        uint32_t face = pending.back();
+        pending.pop_back();
+        if (hull[face].is_removed || hull[face].outside.empty()) continue;
+        add_dot(face, pending);
+    }
+}
+
+//the farthest dot outside of face is added: faces seen from it are found by search from face, every side
+//between seen and not seen faces gets new face with the dot, and dots outside of seen faces are assigned again
+void Quickhull::add_dot(uint32_t face, std::vector<uint32_t>& pending) {
+    uint32_t apex = no_dot;
+    double farthest = 0;
+    for (uint32_t dot : hull[face].outside) {
+        double distance = -orient(face, dot);
+        if (distance > farthest) {
+            apex = dot;
+            farthest = distance;
+        }
+    }
+
+    ++visits;
+    std::vector<uint32_t> seen = {face};
+    std::vector<std::pair<uint32_t, uint32_t>> horizon; //side u -> v, which is kept, and the face behind it
+    std::vector<uint32_t> behind;
+    hull[face].visit = visits;
+    for (size_t s = 0; s < seen.size(); ++s) {
+        const Face& f = hull[seen[s]];
+        for (size_t k = 0; k < 3; ++k) {
+            uint32_t neighbour = f.neighbours[k];
+            if (hull[neighbour].visit == visits) continue;
+            if (orient(neighbour, apex) < 0) {
+                hull[neighbour].visit = visits;
+                seen.push_back(neighbour);
+            }
+            else {
+                horizon.emplace_back(f.vertices[k], f.vertices[(k + 1) % 3]);
+                behind.push_back(neighbour);
+            }
         }
     }
-    friend bool operator<(const Side& s1, const Side& s2) {
-        if (s1.first < s2.first) {
+
+    std::vector<uint32_t> orphans;
+    for (uint32_t s : seen) {
+        for (uint32_t dot : hull[s].outside) {
+            if (dot != apex) orphans.push_back(dot);
+        }
+        hull[s].outside = std::vector<uint32_t>();
+        hull[s].is_removed = true;
+        free_faces.push_back(s);
+    }
+
+    std::vector<uint32_t> created;
+    for (size_t k = 0; k < horizon.size(); ++k) {
+        uint32_t new_face = add_face(horizon[k].first, horizon[k].second, apex);
+        link(new_face, 0, behind[k]);
+        new_face_from[horizon[k].first] = new_face;
+        created.push_back(new_face);
+    }
+    for (uint32_t new_face : created) { //side v -> apex of face u, v, apex is shared with face v, w, apex
+        link(new_face, 1, new_face_from[hull[new_face].vertices[1]]);
+    }
+    assign(orphans, created);
+    for (uint32_t new_face : created) {
+        if (!hull[new_face].outside.empty()) pending.push_back(new_face);
+    }
+}
+
+std::vector<Tetrad> Quickhull::faces() const {
+    std::vector<Tetrad> result;
+    for (const auto& f : hull) {
+        if (f.is_removed) continue;
+        Tetrad face(3);
+        face.second = numbers[f.vertices[0]];
+        face.third = numbers[f.vertices[1]];
+        face.fourth = numbers[f.vertices[2]];
+        face.organize();
+        result.push_back(face);
+    }
+    sort_and_deduplicate(result, points.size());
+    return result;
+}
+
+//faces of convex hull of dots in 3D, vertices of every face go counterclockwise if we look from outside; faces
+//in one plane are parts of a triangulation of the polygon, dots inside of faces are not vertices. If all dots
+//are in one plane, the polygon is triangulated on both sides, and if they are on one line, there are no faces
+std::vector<Tetrad> find_convex_hull(const std::vector<Dot>& dots) {
+    return Quickhull(dots).faces();
+}
+
+//every directed side of faces has exactly one face with the reverse side, so the surface is closed and
+//orientations of faces agree
+bool is_closed_surface(const std::vector<Tetrad>& faces) {
+    std::vector<uint64_t> sides;
+    for (const auto& f : faces) {
+        sides.push_back((uint64_t(f.second) << 32) | f.third);
+        sides.push_back((uint64_t(f.third) << 32) | f.fourth);
+        sides.push_back((uint64_t(f.fourth) << 32) | f.second);
+    }
+    std::sort(sides.begin(), sides.end());
+    for (size_t k = 0; k < sides.size(); ++k) {
+        if (k + 1 < sides.size() && sides[k] == sides[k + 1]) return false;
+        uint64_t reverse = (sides[k] << 32) | (sides[k] >> 32);
+        if (!std::binary_search(sides.begin(), sides.end(), reverse)) return false;
+    }
+    return true;
+}
+
+//index of dot on Hilbert curve of order 16 over the square [0, 2^16)^2
+uint32_t hilbert_index(uint32_t x, uint32_t y) {
+    uint32_t index = 0;
+    for (uint32_t half = 1u << 15; half > 0; half /= 2) {
+        uint32_t rx = (x & half) > 0;
+        uint32_t ry = (y & half) > 0;
+        index += half * half * ((3 * rx) ^ ry);
+        if (ry == 0) { //rotate quadrant
+            if (rx == 1) {
+                x = half - 1 - (x & (half - 1));
+                y = half - 1 - (y & (half - 1));
+            }
+            std::swap(x, y);
+        }
+    }
+    return index;
+}
+
+//biased randomized insertion order: dot goes to round k with probability 2^-(k+1) counted from the last round,
+//rounds go one by one, dots of a round go along Hilbert curve
+std::vector<uint32_t> find_BRIO_order(const std::vector<Point>& points, std::mt19937& generator) {
+    Point low = points.empty() ? Point() : points[0];
+    Point high = low;
+    for (const auto& point : points) {
+        low = Point(std::min(low.x, point.x), std::min(low.y, point.y));
+        high = Point(std::max(high.x, point.x), std::max(high.y, point.y));
+    }
+    double scale = 65535 / std::max({high.x - low.x, high.y - low.y, 1e-300});
+
+    constexpr uint64_t rounds = 24;
+    std::vector<std::pair<uint64_t, uint32_t>> keys(points.size());
+    for (uint32_t i = 0; i < points.size(); ++i) {
+        uint64_t round = rounds - std::min<uint64_t>(rounds, __builtin_clz(generator() | 1u));
+        keys[i] = {(round << 32) | hilbert_index(static_cast<uint32_t>((points[i].x - low.x) * scale),
+                                                 static_cast<uint32_t>((points[i].y - low.y) * scale)), i};
+    }
+    std::sort(keys.begin(), keys.end());
+    std::vector<uint32_t> order(points.size());
+    for (size_t i = 0; i < keys.size(); ++i) order[i] = keys[i].second;
+    return order;
+}
+
+//Delaunay triangulation by insertion of dots one by one with Lawson flips. Triangles are kept in flat arrays
+//of half-edges: half-edge h goes from origins[h] to origins[next(h)] in triangle h / 3, twins[h] is the opposite
+//half-edge. Hull is closed by ghost triangles (u, v, infinite_dot), so dots outside of hull are inserted and
+//flipped as the inner ones: in "circle" of ghost triangle are dots to the left of u -> v and dots inside u v.
+//Triangulation is dynamic: dots are inserted and removed one by one, removed dot leaves a star-shaped hole which
+//is closed by cutting Delaunay ears, freed triangles are reused. Sum of degrees of inner dots and amount of inner
+//dots (they give the answer) are kept up to date from dots around the changed place
+class Incremental_Delaunay {
+public:
+    static constexpr uint32_t infinite_dot = UINT32_MAX;
+
+    explicit Incremental_Delaunay(std::vector<Point> _points, uint32_t seed = 2020);
+
+    //returns number of the new dot, or no_dot if the same dot is already in triangulation
+    uint32_t insert(const Point& point);
+    //returns false if there is no such dot in triangulation
+    bool remove(uint32_t dot);
+
+    size_t size() const { return alive_amount; }
+    bool contains(uint32_t dot) const { return dot < points.size() && is_alive[dot]; }
+
+    //mean degree of dots which are not on hull = mean number of sides of bounded Voronoi cells
+    double average_number_of_sides() const {
+        return (inner_dots_amount == 0 ? 0 : static_cast<double>(inner_degrees_sum) / inner_dots_amount);
+    }
+
+    //triangles without infinite dot, vertices are indices of points
+    std::vector<Tetrad> triangles() const;
+
+private:
+    static constexpr uint32_t removed_triangle = UINT32_MAX - 1; //origin of freed triangles
+    static constexpr uint32_t no_edge = UINT32_MAX;
+
+    static uint32_t next(uint32_t h) { return (h % 3 == 2 ? h - 2 : h + 1); }
+    static uint32_t prev(uint32_t h) { return (h % 3 == 0 ? h + 2 : h - 1); }
+
+    bool is_ghost(uint32_t triangle) const {
+        return origins[3 * triangle] == infinite_dot || origins[3 * triangle + 1] == infinite_dot ||
+               origins[3 * triangle + 2] == infinite_dot;
+    }
+    bool is_real(uint32_t triangle) const {
+        return origins[3 * triangle] != removed_triangle && !is_ghost(triangle);
+    }
+
+    //predicates with the static filter for the box of all dots, they hide the free functions in methods
+    double orientation(const Point& a, const Point& b, const Point& c) const {
+        return geometry::orient2d(a, b, c, bounds);
+    }
+    double in_circle(const Point& a, const Point& b, const Point& c, const Point& d) const {
+        return geometry::incircle(a, b, c, d, bounds);
+    }
+    void extend_box(const Point& point);
+
+    void rebuild();
+    bool is_in_circle(uint32_t triangle, uint32_t dot) const;
+    uint32_t locate(uint32_t dot, uint32_t start) const;
+    void set_corners(uint32_t h, uint32_t a, uint32_t b, uint32_t c); //a, b, c go to h, next(h), prev(h)
+    uint32_t add_triangle(uint32_t a, uint32_t b, uint32_t c);
+    void free_triangle(uint32_t triangle);
+    void link(uint32_t h, uint32_t g) {
+        twins[h] = g;
+        if (g != infinite_dot) twins[g] = h;
+    }
+    bool insert_dot(uint32_t dot, uint32_t start);
+    uint32_t jump(uint32_t dot);
+    void split(uint32_t dot, uint32_t triangle);
+    void flip(uint32_t h);
+    void legalize(uint32_t h);
+    void cut_ear(std::vector<uint32_t>& spokes, size_t i);
+    void update_statistic(uint32_t dot);
+
+    std::vector<Point> points;
+    Point box_min;
+    Point box_max;
+    geometry::Static_error_bounds bounds;
+    std::vector<uint8_t> is_alive;
+    std::vector<uint32_t> edge_from; //some half-edge going from the dot
+    std::vector<uint32_t> origins;
+    std::vector<uint32_t> twins;
+    std::vector<uint32_t> free_triangles;
+    std::vector<uint32_t> flip_stack;
+    std::vector<uint32_t> spokes_buffer;
+    std::vector<std::pair<double, size_t>> ears_buffer;
+    std::mt19937 generator;
+    uint32_t last_triangle = 0;
+    bool is_tracking_edges = false; //edge_from is filled in one pass after building from scratch
+    size_t real_triangles = 0;
+    size_t alive_amount = 0;
+
+    std::vector<uint32_t> inner_degrees; //degree of inner dot, 0 for dots on hull
+    size_t inner_degrees_sum = 0;
+    size_t inner_dots_amount = 0;
+};
+
+Incremental_Delaunay::Incremental_Delaunay(std::vector<Point> _points, uint32_t seed)
+        : points(std::move(_points))
+        , is_alive(points.size(), 1)
+        , generator(seed)
+        , alive_amount(points.size()) {
+    if (!points.empty()) box_min = box_max = points[0];
+    for (const Point& point : points) extend_box(point);
+    rebuild();
+}
+
+void Incremental_Delaunay::extend_box(const Point& point) {
+    if (points.size() == 1) box_min = box_max = point;
+    if (point.x >= box_min.x && point.x <= box_max.x && point.y >= box_min.y && point.y <= box_max.y) return;
+    box_min = Point(std::min(box_min.x, point.x), std::min(box_min.y, point.y));
+    box_max = Point(std::max(box_max.x, point.x), std::max(box_max.y, point.y));
+    bounds = geometry::Static_error_bounds(std::max(box_max.x - box_min.x, box_max.y - box_min.y));
+}
+
+//triangulation of alive dots from scratch, dots which are repeated or do not fit are not alive after that
+void Incremental_Delaunay::rebuild() {
+    std::vector<uint32_t> order = find_BRIO_order(points, generator);
+    order.erase(std::remove_if(order.begin(), order.end(), [this](uint32_t dot) { return !is_alive[dot]; }),
+                order.end());
+    origins.clear();
+    twins.clear();
+    free_triangles.clear();
+    origins.reserve(6 * points.size());
+    twins.reserve(6 * points.size());
+    edge_from.assign(points.size(), no_edge);
+    inner_degrees.assign(points.size(), 0);
+    inner_degrees_sum = inner_dots_amount = 0;
+    real_triangles = 0;
+    last_triangle = 0;
+    is_tracking_edges = false;
+
+    //the first triangle is made of two first dots and the first dot which is not on their line
+    size_t first = 0;
+    size_t second = 1;
+    while (second < order.size() && points[order[first]] == points[order[second]]) { //the least number stays
+        if (order[second] < order[first]) std::swap(order[first], order[second]);
+        is_alive[order[second++]] = 0;
+    }
+    size_t third = second + 1;
+    while (third < order.size() && orientation(points[order[first]], points[order[second]],
+            points[order[third]]) == 0) {
+        ++third;
+    }
+    if (third >= order.size()) { //all dots are on one line, there are no triangles
+        //of equal dots only the one with the least number stays, so a repeated dot is not inserted
+        std::sort(order.begin(), order.end(), [this](uint32_t u, uint32_t v) {
+            return std::tie(points[u].x, points[u].y, u) < std::tie(points[v].x, points[v].y, v);
+        });
+        for (size_t i = 1; i < order.size(); ++i) {
+            if (points[order[i]] == points[order[i - 1]]) is_alive[order[i]] = 0;
+        }
+        alive_amount = std::count(is_alive.begin(), is_alive.end(), 1);
+        return;
+    }
+
+    uint32_t a = order[first];
+    uint32_t b = order[second];
+    uint32_t c = order[third];
+    if (orientation(points[a], points[b], points[c]) < 0) std::swap(b, c);
+    add_triangle(a, b, c);
+    add_triangle(b, a, infinite_dot);
+    add_triangle(c, b, infinite_dot);
+    add_triangle(a, c, infinite_dot);
+    link(0, 3);
+    link(1, 6);
+    link(2, 9);
+    link(4, 11); //a -> infinite in (b, a, inf) and infinite -> a in (a, c, inf)
+    link(7, 5);  //b -> infinite in (c, b, inf) and infinite -> b in (b, a, inf)
+    link(10, 8); //c -> infinite in (a, c, inf) and infinite -> c in (c, b, inf)
+
+    for (size_t i = second + 1; i < order.size(); ++i) {
+        if (i != third && !insert_dot(order[i], last_triangle)) is_alive[order[i]] = 0;
+    }
+    alive_amount = std::count(is_alive.begin(), is_alive.end(), 1);
+    for (uint32_t h = 0; h < origins.size(); ++h) {
+        if (origins[h] < removed_triangle) edge_from[origins[h]] = h;
+    }
+    is_tracking_edges = true;
+
+    //every real side u -> v is a half-edge of one triangle, real or ghost, so degree of u is the amount of
+    //half-edges from u to real dots; dots with half-edges to infinite dot are on hull
+    for (uint32_t h = 0; h < origins.size(); ++h) {
+        uint32_t u = origins[h];
+        uint32_t v = origins[next(h)];
+        if (u == infinite_dot || u == removed_triangle) continue;
+        if (v == infinite_dot) inner_degrees[u] = no_edge;
+        else if (inner_degrees[u] != no_edge) ++inner_degrees[u];
+    }
+    for (uint32_t dot = 0; dot < points.size(); ++dot) {
+        if (inner_degrees[dot] == no_edge) inner_degrees[dot] = 0;
+        inner_degrees_sum += inner_degrees[dot];
+        inner_dots_amount += (inner_degrees[dot] > 0);
+    }
+}
+
+void Incremental_Delaunay::set_corners(uint32_t h, uint32_t a, uint32_t b, uint32_t c) {
+    uint32_t triangle = h / 3;
+    real_triangles -= is_real(triangle);
+    origins[h] = a;
+    origins[next(h)] = b;
+    origins[prev(h)] = c;
+    real_triangles += is_real(triangle);
+    if (!is_tracking_edges) return;
+    if (a != infinite_dot) edge_from[a] = h;
+    if (b != infinite_dot) edge_from[b] = next(h);
+    if (c != infinite_dot) edge_from[c] = prev(h);
+}
+
+uint32_t Incremental_Delaunay::add_triangle(uint32_t a, uint32_t b, uint32_t c) {
+    uint32_t triangle;
+    if (free_triangles.empty()) {
+        triangle = static_cast<uint32_t>(origins.size() / 3);
+        origins.insert(origins.end(), {removed_triangle, removed_triangle, removed_triangle});
+        twins.insert(twins.end(), {infinite_dot, infinite_dot, infinite_dot});
+    }
+    else {
+        triangle = free_triangles.back();
+        free_triangles.pop_back();
+    }
+    set_corners(3 * triangle, a, b, c);
+    return triangle;
+}
+
+void Incremental_Delaunay::free_triangle(uint32_t triangle) {
+    real_triangles -= is_real(triangle);
+    for (uint32_t h = 3 * triangle; h < 3 * triangle + 3; ++h) {
+        origins[h] = removed_triangle;
+        twins[h] = infinite_dot;
+    }
+    free_triangles.push_back(triangle);
+}
+
+bool Incremental_Delaunay::is_in_circle(uint32_t triangle, uint32_t dot) const {
+    uint32_t h = 3 * triangle;
+    if (!is_ghost(triangle)) {
+        return geometry::incircle_perturbed(points[origins[h]], points[origins[h + 1]], points[origins[h + 2]],
+                points[dot], origins[h], origins[h + 1], origins[h + 2], dot, bounds) > 0;
+    }
+    while (origins[prev(h)] != infinite_dot) h = next(h); //h goes from u to v, infinite dot is the third
+    const Point& u = points[origins[h]];
+    const Point& v = points[origins[next(h)]];
+    double turn = orientation(u, v, points[dot]);
+    return turn > 0 || (turn == 0 && scalar_product(u - points[dot], v - points[dot]) < 0);
+}
+
+//walk from start to the triangle which contains dot: through any edge which has dot to the right; the first
+//ghost triangle is the answer for dots outside of hull; infinite_dot is returned for repeated dots
+uint32_t Incremental_Delaunay::locate(uint32_t dot, uint32_t start) const {
+    const Point& point = points[dot];
+    uint32_t triangle = start;
+    if (is_ghost(start)) { //walk starts from the real triangle behind the hull edge
+        uint32_t h = 3 * start;
+        while (origins[h] == infinite_dot || origins[next(h)] == infinite_dot) h = next(h);
+        triangle = twins[h] / 3;
+    }
+    for (size_t steps = 0; steps < origins.size(); ++steps) {
+        if (is_ghost(triangle)) return triangle;
+        bool is_moved = false;
+        for (uint32_t k = 0; k < 3 && !is_moved; ++k) {
+            uint32_t h = 3 * triangle + (k + steps) % 3; //edges are tried from different ones against cycles
+            if (orientation(points[origins[h]], points[origins[next(h)]], point) < 0) {
+                triangle = twins[h] / 3;
+                is_moved = true;
+            }
+        }
+        if (!is_moved) {
+            for (uint32_t k = 0; k < 3; ++k) {
+                if (points[origins[3 * triangle + k]] == point) return infinite_dot;
+            }
+            return triangle;
+        }
+    }
+
+    //walk in Delaunay triangulation with exact predicates always ends, linear search for the first triangle
+    //which has the dot not outside is only a guard
+    for (uint32_t t = 0; t < origins.size() / 3; ++t) {
+        if (is_real(t) && orientation(points[origins[3 * t]], points[origins[3 * t + 1]], point) >= 0 &&
+            orientation(points[origins[3 * t + 1]], points[origins[3 * t + 2]], point) >= 0 &&
+            orientation(points[origins[3 * t + 2]], points[origins[3 * t]], point) >= 0) {
+            for (uint32_t k = 0; k < 3; ++k) {
+                if (points[origins[3 * t + k]] == point) return infinite_dot;
+            }
+            return t;
+        }
+    }
+    for (uint32_t t = 0; t < origins.size() / 3; ++t) {
+        if (origins[3 * t] != removed_triangle && is_ghost(t) && is_in_circle(t, dot)) return t;
+    }
+    return infinite_dot;
+}
+
+bool Incremental_Delaunay::insert_dot(uint32_t dot, uint32_t start) {
+    uint32_t triangle = locate(dot, start);
+    if (triangle == infinite_dot) return false;
+    split(dot, triangle);
+    return true;
+}
+
+//triangle (a, b, c) is split into (a, b, dot), (b, c, dot), (c, a, dot), then edges opposite to dot are legalized
+void Incremental_Delaunay::split(uint32_t dot, uint32_t triangle) {
+    uint32_t h = 3 * triangle;
+    uint32_t a = origins[h], b = origins[h + 1], c = origins[h + 2];
+    uint32_t twin_bc = twins[h + 1];
+    uint32_t twin_ca = twins[h + 2];
+
+    set_corners(h, a, b, dot);
+    uint32_t second = add_triangle(b, c, dot);
+    uint32_t third = add_triangle(c, a, dot);
+    link(3 * second, twin_bc);
+    link(3 * third, twin_ca);
+    link(h + 1, 3 * second + 2);         //b -> dot and dot -> b
+    link(3 * second + 1, 3 * third + 2); //c -> dot and dot -> c
+    link(3 * third + 1, h + 2);          //a -> dot and dot -> a
+
+    last_triangle = triangle;
+    legalize(h);
+    legalize(3 * second);
+    legalize(3 * third);
+}
+
+//h is an edge a -> b of triangle (a, b, dot), triangle on the other side is (b, a, d);
+//they become (d, dot, a) and (dot, d, b), h goes from d to dot
+void Incremental_Delaunay::flip(uint32_t h) {
+    uint32_t g = twins[h];
+    uint32_t a = origins[h];
+    uint32_t b = origins[next(h)];
+    uint32_t dot = origins[prev(h)];
+    uint32_t d = origins[prev(g)];
+    uint32_t twin_b_dot = twins[next(h)];
+    uint32_t twin_dot_a = twins[prev(h)];
+    uint32_t twin_a_d = twins[next(g)];
+    uint32_t twin_d_b = twins[prev(g)];
+
+    set_corners(h, d, dot, a);
+    set_corners(g, dot, d, b);
+    link(h, g);
+    link(next(h), twin_dot_a);
+    link(prev(h), twin_a_d);
+    link(next(g), twin_d_b);
+    link(prev(g), twin_b_dot);
+    last_triangle = h / 3;
+}
+
+//if dot opposite to h is in circle of the triangle on the other side, h is flipped
+//and two new edges opposite to dot are checked
+void Incremental_Delaunay::legalize(uint32_t h) {
+    flip_stack.push_back(h);
+    while (!flip_stack.empty()) {
+        h = flip_stack.back();
+        flip_stack.pop_back();
+        uint32_t g = twins[h];
+        if (g == infinite_dot || !is_in_circle(g / 3, origins[prev(h)])) continue;
+        flip(h);
+        flip_stack.push_back(prev(h)); //a -> d
+        flip_stack.push_back(next(g)); //d -> b
+    }
+}
+
+//start of walk for a dot far from the last change: the nearest of about n^(1/3) random dots (jump-and-walk)
+uint32_t Incremental_Delaunay::jump(uint32_t dot) {
+    uint32_t start = last_triangle;
+    double best = INF;
+    size_t samples = static_cast<size_t>(std::cbrt(static_cast<double>(alive_amount))) + 1;
+    for (size_t k = 0; k < samples; ++k) {
+        uint32_t sample = static_cast<uint32_t>(generator() % points.size());
+        if (!is_alive[sample] || edge_from[sample] == no_edge) continue;
+        double length = (points[sample] - points[dot]).squared_length();
+        if (length < best) {
+            best = length;
+            start = edge_from[sample] / 3;
+        }
+    }
+    return start;
+}
+
+uint32_t Incremental_Delaunay::insert(const Point& point) {
+    uint32_t dot = static_cast<uint32_t>(points.size());
+    points.push_back(point);
+    extend_box(point);
+    is_alive.push_back(1);
+    edge_from.push_back(no_edge);
+    inner_degrees.push_back(0);
+    ++alive_amount;
+    if (real_triangles == 0) { //dots were on one line, maybe the new one is not; alive dots are recounted
+        rebuild();
+    }
+    else if (!insert_dot(dot, jump(dot))) {
+        is_alive[dot] = 0;
+        --alive_amount;
+    }
+    if (!is_alive[dot]) return no_dot;
+
+    if (edge_from[dot] != no_edge) { //dot and its neighbours are the only ones whose cells changed
+        uint32_t start = edge_from[dot];
+        uint32_t h = start;
+        do {
+            if (origins[next(h)] != infinite_dot) update_statistic(origins[next(h)]);
+            h = twins[prev(h)];
+        } while (h != start);
+        update_statistic(dot);
+    }
+    return dot;
+}
+
+//spokes are edges from removed dot to its neighbours q[0], q[1], ... counterclockwise; spoke to q[i] is flipped,
+//so ear (q[i - 1], q[i], q[i + 1]) becomes a triangle and q[i] is not a neighbour anymore
+void Incremental_Delaunay::cut_ear(std::vector<uint32_t>& spokes, size_t i) {
+    size_t before = (i == 0 ? spokes.size() - 1 : i - 1);
+    uint32_t h = spokes[i];
+    flip(h);
+    spokes[before] = prev(h); //from removed dot to q[i - 1] in (q[i - 1], q[i + 1], dot)
+    spokes.erase(spokes.begin() + i);
+}
+
+//hole around the dot is closed by ears with maximal power of the dot relative to their circles, such ears are
+//Delaunay (Devillers); if the dot is on hull, only ears between its hull neighbours are cut while there are
+//convex ones, and triangles left around the dot become ghost ones
+bool Incremental_Delaunay::remove(uint32_t dot) {
+    if (!contains(dot)) return false;
+    is_alive[dot] = 0;
+    --alive_amount;
+    if (edge_from[dot] == no_edge) return true;
+
+    std::vector<uint32_t>& spokes = spokes_buffer;
+    spokes.clear();
+    uint32_t start = edge_from[dot];
+    uint32_t h = start;
+    size_t infinite_spoke = no_edge;
+    do {
+        if (origins[next(h)] == infinite_dot) infinite_spoke = spokes.size();
+        spokes.push_back(h);
+        h = twins[prev(h)];
+    } while (h != start);
+    bool is_on_hull = (infinite_spoke != no_edge);
+    if (is_on_hull) { //chain of real neighbours goes first, spoke to infinity is the last
+        std::rotate(spokes.begin(), spokes.begin() + infinite_spoke + 1, spokes.end());
+    }
+    std::vector<uint32_t> neighbours;
+    for (uint32_t spoke : spokes) {
+        if (origins[next(spoke)] != infinite_dot) neighbours.push_back(origins[next(spoke)]);
+    }
+    update_statistic(dot);
+
+    auto number = [this, &spokes](size_t i) { return origins[next(spokes[i])]; };
+    auto neighbour = [this, &number](size_t i) { return points[number(i)]; };
+    auto before_of = [&spokes](size_t i) { return (i == 0 ? spokes.size() - 1 : i - 1); };
+    auto after_of = [&spokes](size_t i) { return (i + 1 == spokes.size() ? 0 : i + 1); };
+    //power is rounded and is the same for ears on one circle, so the ear is taken only if no other neighbour is
+    //in its circle with the same perturbation as in insertion: then the hole gets the triangles which building
+    //from scratch would give
+    auto is_empty_ear = [&](size_t i) {
+        size_t b = before_of(i), a = after_of(i);
+        for (size_t j = 0; j < spokes.size(); ++j) {
+            if (j == b || j == i || j == a || number(j) == infinite_dot) continue;
+            if (geometry::incircle_perturbed(neighbour(b), neighbour(i), neighbour(a), neighbour(j), number(b),
+                    number(i), number(a), number(j), bounds) > 0) return false;
+        }
+        return true;
+    };
+    const Point& center = points[dot];
+    std::vector<std::pair<double, size_t>>& ears = ears_buffer; //power of the dot relative to ear and the ear
+    while (spokes.size() > 3) {
+        ears.clear();
+        size_t from = (is_on_hull ? 1 : 0);
+        size_t to = (is_on_hull ? spokes.size() - 2 : spokes.size());
+        for (size_t i = from; i < to; ++i) {
+            const Point& before = neighbour(before_of(i));
+            const Point& after = neighbour(after_of(i));
+            double turn = orientation(before, neighbour(i), after);
+            //dot may be on the diagonal, triangle (dot, before, after) is only temporary
+            if (turn <= 0 || orientation(before, after, center) < 0) continue;
+            ears.emplace_back(-in_circle(before, neighbour(i), after, center) / turn, i);
+        }
+        if (ears.empty()) break;
+        std::sort(ears.begin(), ears.end(), std::greater<std::pair<double, size_t>>());
+        size_t best = no_edge;
+        for (const auto& ear : ears) {
+            if (is_empty_ear(ear.second)) {
+                best = ear.second;
+                break;
+            }
+        }
+        if (best == no_edge) { //exact predicates do not allow it: guard
+            rebuild();
             return true;
         }
-        else {
-            return (s1.first == s2.first && s1.second < s2.second);
+        cut_ear(spokes, best);
+    }
+
+    if (!is_on_hull && spokes.size() == 3) { //(dot, q0, q1), (dot, q1, q2), (dot, q2, q0) become (q0, q1, q2)
+        uint32_t triangle = spokes[0] / 3;
+        uint32_t q[3], outer[3];
+        for (size_t k = 0; k < 3; ++k) {
+            q[k] = origins[next(spokes[k])];
+            outer[k] = twins[next(spokes[k])];
         }
+        free_triangle(spokes[1] / 3);
+        free_triangle(spokes[2] / 3);
+        set_corners(3 * triangle, q[0], q[1], q[2]);
+        for (uint32_t k = 0; k < 3; ++k) link(3 * triangle + k, outer[k]);
+        last_triangle = triangle;
     }
-    size_t first;
-    size_t second;
+    else if (is_on_hull) { //dot becomes infinite in triangles between the hull neighbours
+        uint32_t last = spokes[spokes.size() - 2];  //dot -> x in (dot, x, inf)
+        uint32_t to_infinity = spokes.back();        //dot -> inf in (dot, inf, y)
+        uint32_t twin_x = twins[next(last)];         //inf -> x
+        uint32_t twin_y = twins[next(to_infinity)];  //y -> inf
+        uint32_t first_spoke = spokes[0];            //dot -> y in (dot, y, q1)
+        uint32_t last_side = twins[last];            //x -> dot in (dot, q, x)
+        free_triangle(last / 3);
+        free_triangle(to_infinity / 3);
+        for (size_t i = 0; i + 2 < spokes.size(); ++i) {
+            uint32_t spoke = spokes[i];
+            set_corners(spoke, infinite_dot, origins[next(spoke)], origins[prev(spoke)]);
+        }
+        link(first_spoke, twin_y);
+        link(last_side, twin_x);
+        last_triangle = first_spoke / 3;
+    }
+    else { //no ear is found, which exact predicates do not allow: guard
+        rebuild();
+        return true;
+    }
+    edge_from[dot] = no_edge;
+
+    if (real_triangles == 0) { //the rest of dots is on one line
+        rebuild();
+        return true;
+    }
+    for (uint32_t q : neighbours) update_statistic(q);
+    return true;
+}
+
+//degree of dot is counted by walk around it
+void Incremental_Delaunay::update_statistic(uint32_t dot) {
+    size_t degree = 0;
+    bool is_inner = is_alive[dot] && edge_from[dot] != no_edge;
+    if (is_inner) {
+        uint32_t start = edge_from[dot];
+        uint32_t h = start;
+        do {
+            if (origins[next(h)] == infinite_dot) is_inner = false;
+            ++degree;
+            h = twins[prev(h)];
+        } while (h != start);
+    }
+    inner_degrees_sum -= inner_degrees[dot];
+    inner_dots_amount -= (inner_degrees[dot] > 0);
+    inner_degrees[dot] = (is_inner ? static_cast<uint32_t>(degree) : 0);
+    inner_degrees_sum += inner_degrees[dot];
+    inner_dots_amount += (inner_degrees[dot] > 0);
+}
+
+std::vector<Tetrad> Incremental_Delaunay::triangles() const {
+    std::vector<Tetrad> result;
+    Tetrad tmp(3);
+    for (uint32_t t = 0; t < origins.size() / 3; ++t) {
+        if (!is_real(t)) continue;
+        tmp.second = origins[3 * t];
+        tmp.third = origins[3 * t + 1];
+        tmp.fourth = origins[3 * t + 2];
+        tmp.organize();
+        result.push_back(tmp);
+    }
+    return result;
+}
+
+enum class Delaunay_backend {
+    kinetic,     //lower convex hull of dots lifted onto paraboloid
+    incremental  //Incremental_Delaunay
 };
 
-std::pair<size_t, size_t> count_inner_Voronoi_diagram_sides(const std::set<Tetrad>& triangulation
-        , size_t number_of_dots) {
-    std::set<Side> out_sides;
-    std::set<Side> inner_side;
-    Side a, b, c;
+std::vector<Tetrad> find_Delaunay_triangulation_incrementally(const std::vector<Dot>& dots) {
+    std::vector<Point> points(dots.size());
+    for (const auto& d : dots) points[d.number] = Point(d.current.x, d.current.y);
+    std::vector<Tetrad> triangulation = Incremental_Delaunay(std::move(points)).triangles();
+    sort_and_deduplicate(triangulation, dots.size());
+    return triangulation;
+}
+
+//corners has three dots of every triangle, side h goes from corners[h] to the next corner of its triangle;
+//returns side going backwards on the same two dots for every side, or UINT32_MAX for hull sides. Sides are
+//sorted by (min, max) of ends, twins are neighbours in sorted order; a side met more than twice (overlapping
+//triangles from rounding errors) is left without twins
+std::vector<uint32_t> find_twin_sides(const std::vector<uint32_t>& corners, size_t number_of_dots) {
+    auto side_next = [](uint32_t h) { return (h % 3 == 2 ? h - 2 : h + 1); };
+    const uint32_t sides = static_cast<uint32_t>(corners.size());
+    const unsigned bits = bits_for(number_of_dots);
+    std::vector<std::pair<uint64_t, uint32_t>> keys(sides);
+    for (uint32_t h = 0; h < sides; ++h) {
+        uint64_t u = corners[h], v = corners[side_next(h)];
+        keys[h] = {(std::min(u, v) << bits) | std::max(u, v), h};
+    }
+    std::vector<std::pair<uint64_t, uint32_t>> buffer;
+    radix_sort(keys, buffer, [](const std::pair<uint64_t, uint32_t>& key) { return key.first; }, 2 * bits);
+    buffer = std::vector<std::pair<uint64_t, uint32_t>>();
+
+    std::vector<uint32_t> twins(sides, UINT32_MAX);
+    for (size_t k = 0; k < keys.size();) {
+        size_t end = k + 1;
+        while (end < keys.size() && keys[end].first == keys[k].first) ++end;
+        if (end - k == 2 && corners[keys[k].second] != corners[keys[k + 1].second]) {
+            twins[keys[k].second] = keys[k + 1].second;
+            twins[keys[k + 1].second] = keys[k].second;
+        }
+        k = end;
+    }
+    return twins;
+}
+
+//triangulation is checked by exact predicates: triangles are not degenerate, every side is shared by two triangles
+//going opposite ways or is a side of hull, sides of hull go around once with left turns, every dot is used and
+//there are 2n - 2 - h triangles, so triangles cover the hull once; then every inner side has to be locally Delaunay
+bool is_Delaunay_triangulation(const std::vector<Tetrad>& triangulation, const std::vector<Point>& points) {
+    const size_t n = points.size();
+    std::vector<uint32_t> corners;
+    corners.reserve(3 * triangulation.size());
+    std::vector<uint8_t> is_used(n, 0);
     for (const auto& t : triangulation) {
-        a = Side(t.second, t.third);
-        b = Side(t.fourth, t.third);
-        c = Side(t.fourth, t.second);
-        //iff side is inner, we meet it twice
-        auto insert_res = out_sides.insert(a);
-        if (!insert_res.second) {
-            out_sides.erase(a);
-            inner_side.insert(a);
+        uint32_t a = t.second, b = t.third, c = t.fourth;
+        if (a >= n || b >= n || c >= n) return false;
+        double turn = orientation(points[a], points[b], points[c]);
+        if (turn == 0) return false;
+        if (turn < 0) std::swap(b, c);
+        corners.insert(corners.end(), {a, b, c});
+        is_used[a] = is_used[b] = is_used[c] = 1;
+    }
+    if (triangulation.empty() || std::find(is_used.begin(), is_used.end(), 0) != is_used.end()) return false;
+
+    auto side_next = [](uint32_t h) { return (h % 3 == 2 ? h - 2 : h + 1); };
+    auto opposite = [&corners, &side_next](uint32_t h) { return corners[side_next(side_next(h))]; };
+    const std::vector<uint32_t> twins = find_twin_sides(corners, n);
+    std::vector<uint32_t> hull_next(n, no_dot); //dots of hull go counterclockwise
+    size_t hull_sides = 0;
+    for (uint32_t h = 0; h < corners.size(); ++h) {
+        uint32_t a = corners[h], b = corners[side_next(h)];
+        if (twins[h] == UINT32_MAX) {
+            if (hull_next[a] != no_dot) return false;
+            hull_next[a] = b;
+            ++hull_sides;
+        }
+        else if (h < twins[h] && in_circle(points[a], points[b], points[opposite(h)], points[opposite(twins[h])]) > 0) {
+            return false;
         }
+    }
+    if (triangulation.size() + hull_sides + 2 != 2 * n) return false;
 
-        insert_res = out_sides.insert(b);
-        if (!insert_res.second) {
-            out_sides.erase(b);
-            inner_side.insert(b);
+    //directions of sides of a convex polygon go once around: from the lower half-plane to the upper one only once
+    auto is_lower = [&points](uint32_t a, uint32_t b) {
+        return points[b].y < points[a].y || (points[b].y == points[a].y && points[b].x < points[a].x);
+    };
+    const uint32_t start = corners[std::find_if(twins.begin(), twins.end(), [](uint32_t twin) {
+        return twin == UINT32_MAX;
+    }) - twins.begin()];
+    size_t steps = 0;
+    size_t wraps = 0;
+    uint32_t a = start;
+    do {
+        uint32_t b = hull_next[a];
+        uint32_t c = (b == no_dot ? no_dot : hull_next[b]);
+        if (c == no_dot || orientation(points[a], points[b], points[c]) <= 0) return false;
+        wraps += (is_lower(a, b) && !is_lower(b, c));
+        a = b;
+    } while (a != start && ++steps < hull_sides);
+    return a == start && steps + 1 == hull_sides && wraps == 1;
+}
+
+//event times of kinetic hull are rounded, so dots which are almost on one circle or have the same x may break
+//its triangulation; it is checked, and the triangulation is built incrementally if the check fails
+std::vector<Tetrad> find_Delaunay_triangulation(const std::vector<Dot>& dots, size_t threads_amount,
+        Delaunay_backend backend) {
+    if (backend == Delaunay_backend::kinetic) {
+        std::vector<Point> points(dots.size());
+        for (const auto& d : dots) points[d.number] = Point(d.current.x, d.current.y);
+        std::vector<Tetrad> triangulation = find_Delaunay_triangulation(dots, threads_amount);
+        if (is_Delaunay_triangulation(triangulation, points)) return triangulation;
+    }
+    return find_Delaunay_triangulation_incrementally(dots);
+}
+
+//Voronoi diagram dual to a Delaunay triangulation. Voronoi vertex t is the circumcenter of triangle t.
+//Half-edge e < 3 * triangles is dual to side e % 3 of triangle e / 3 going from a to b: it bounds cell of a
+//and goes counterclockwise around a from the circumcenter behind a -> b to the circumcenter of the triangle.
+//Hull side a -> b has no triangle behind it, so its half-edge comes from infinity, and its twin is an extra
+//half-edge 3 * triangles + k (k is the number of the ray) which goes from the circumcenter to infinity
+class Voronoi_diagram {
+public:
+    static constexpr uint32_t at_infinity = UINT32_MAX;
+    static constexpr uint32_t no_edge = UINT32_MAX;
+    static constexpr double unbounded = std::numeric_limits<double>::infinity(); //area of unbounded cells
+
+    Voronoi_diagram(std::vector<Point> _sites, const std::vector<Tetrad>& triangulation);
+
+    size_t cells_amount() const { return sites.size(); }
+    size_t vertices_amount() const { return vertices.size(); }
+    size_t half_edges_amount() const { return origins.size(); }
+    size_t rays_amount() const { return ray_sides.size(); }
+
+    const Point& site(uint32_t cell) const { return sites[cell]; }
+    const Point& vertex(uint32_t v) const { return vertices[v]; }
+    uint32_t origin(uint32_t e) const { return origins[e]; } //at_infinity for incoming rays
+    uint32_t target(uint32_t e) const { return origins[twins[e]]; }
+    uint32_t twin(uint32_t e) const { return twins[e]; }
+    uint32_t next(uint32_t e) const { return nexts[e]; }
+    uint32_t cell_of(uint32_t e) const { return cells[e]; }
+    uint32_t first_edge(uint32_t cell) const { return first_edges[cell]; } //no_edge for dots out of triangulation
+    bool is_bounded(uint32_t cell) const { return areas[cell] < unbounded; }
+    double area(uint32_t cell) const { return areas[cell]; } //unbounded for unbounded cells and repeated dots
+    size_t sides_amount(uint32_t cell) const;
+    Point ray_direction(uint32_t e) const; //for half-edges from or to infinity: direction away from the hull
+
+    //mean number of sides of bounded cells, 0 if there are no such cells
+    double average_number_of_sides() const;
+
+    //little-endian binary: "VOR1", uint32 amounts of cells, vertices, half-edges and rays; vertices as pairs
+    //of double; origin, twin, next, cell of every half-edge as uint32; first edge of every cell as uint32;
+    //area of every cell as double, +infinity for unbounded cells and cells of repeated dots; hull side (half-edge
+    //coming from infinity) of every ray as uint32
+    void write(std::ostream& out) const;
+
+private:
+    std::vector<Point> sites;
+    std::vector<Point> vertices;
+    std::vector<uint32_t> origins;
+    std::vector<uint32_t> twins;
+    std::vector<uint32_t> nexts;
+    std::vector<uint32_t> cells;
+    std::vector<uint32_t> first_edges;
+    std::vector<double> areas;
+    std::vector<uint32_t> ray_sides;
+};
+
+Point find_circumcenter(const Point& a, const Point& b, const Point& c) {
+    Point ab = b - a;
+    Point ac = c - a;
+    double d = 2 * vector_product(ab, ac);
+    double ab_length = ab.squared_length();
+    double ac_length = ac.squared_length();
+    return a + Point((ac.y * ab_length - ab.y * ac_length) / d, (ab.x * ac_length - ac.x * ab_length) / d);
+}
+
+Voronoi_diagram::Voronoi_diagram(std::vector<Point> _sites, const std::vector<Tetrad>& triangulation)
+        : sites(std::move(_sites)), first_edges(sites.size(), no_edge), areas(sites.size(), 0) {
+    const uint32_t triangles = static_cast<uint32_t>(triangulation.size());
+    const uint32_t sides = 3 * triangles;
+    origins.resize(sides);
+    vertices.resize(triangles);
+    for (uint32_t t = 0; t < triangles; ++t) {
+        uint32_t a = triangulation[t].second, b = triangulation[t].third, c = triangulation[t].fourth;
+        if (orientation(sites[a], sites[b], sites[c]) < 0) std::swap(b, c);
+        origins[3 * t] = a;
+        origins[3 * t + 1] = b;
+        origins[3 * t + 2] = c;
+        vertices[t] = find_circumcenter(sites[a], sites[b], sites[c]);
+    }
+    auto side_next = [](uint32_t h) { return (h % 3 == 2 ? h - 2 : h + 1); };
+    auto side_prev = [](uint32_t h) { return (h % 3 == 0 ? h + 2 : h - 1); };
+    twins = find_twin_sides(origins, sites.size());
+
+    //half-edge of side a -> b in triangle t goes from the circumcenter behind a -> b to vertex t,
+    //the next one around a is dual to side a -> c, the twin of c -> a
+    cells.resize(sides);
+    nexts.resize(sides);
+    std::vector<uint32_t> hull_side_from(sites.size(), no_edge);
+    for (uint32_t h = 0; h < sides; ++h) {
+        cells[h] = origins[h];
+        first_edges[origins[h]] = h;
+        if (twins[h] == at_infinity) hull_side_from[origins[h]] = h;
+    }
+    for (uint32_t h = 0; h < sides; ++h) {
+        if (twins[h] == at_infinity) { //outgoing ray of cell of b is added as the twin of a -> b
+            uint32_t ray = sides + static_cast<uint32_t>(ray_sides.size());
+            ray_sides.push_back(h);
+            twins[h] = ray;
+            twins.push_back(h);
+            cells.push_back(origins[side_next(h)]);
+            nexts.push_back(no_edge);
+        }
+    }
+    for (uint32_t h = 0; h < sides; ++h) nexts[h] = twins[side_prev(h)];
+    for (uint32_t k = 0; k < ray_sides.size(); ++k) { //after the outgoing ray comes the incoming one
+        nexts[sides + k] = hull_side_from[cells[sides + k]];
+    }
+    for (uint32_t h = 0; h < sides; ++h) origins[h] = (twins[h] < sides ? twins[h] / 3 : at_infinity);
+    for (uint32_t k = 0; k < ray_sides.size(); ++k) origins.push_back(ray_sides[k] / 3);
+    for (uint32_t h = 0; h < sides; ++h) { //incoming rays are first edges of unbounded cells
+        if (origins[h] == at_infinity) first_edges[cells[h]] = h;
+    }
+
+    for (uint32_t e = 0; e < origins.size(); ++e) {
+        uint32_t cell = cells[e];
+        if (origins[e] == at_infinity || target(e) == at_infinity) {
+            areas[cell] = unbounded;
+        }
+        else if (areas[cell] < unbounded) {
+            areas[cell] += vector_product(vertices[origins[e]] - sites[cell], vertices[target(e)] - sites[cell]) / 2;
+        }
+    }
+    for (uint32_t cell = 0; cell < sites.size(); ++cell) {
+        if (first_edges[cell] == no_edge) areas[cell] = unbounded;
+    }
+}
+
+size_t Voronoi_diagram::sides_amount(uint32_t cell) const {
+    if (first_edges[cell] == no_edge) return 0;
+    size_t result = 0;
+    uint32_t e = first_edges[cell];
+    do { //the limit keeps broken cycles of an invalid triangulation finite
+        ++result;
+        e = nexts[e];
+    } while (e != first_edges[cell] && e != no_edge && result < origins.size());
+    return result;
+}
+
+Point Voronoi_diagram::ray_direction(uint32_t e) const {
+    uint32_t h = (origins[e] == at_infinity ? e : twins[e]); //hull side a -> b, outside is to the right
+    Point side = sites[cells[twins[h]]] - sites[cells[h]];
+    return Point(side.y, -side.x);
+}
+
+double Voronoi_diagram::average_number_of_sides() const {
+    size_t sides = 0;
+    size_t bounded = 0;
+    for (uint32_t cell = 0; cell < sites.size(); ++cell) {
+        if (!is_bounded(cell)) continue;
+        sides += sides_amount(cell);
+        ++bounded;
+    }
+    return (bounded == 0 ? 0 : static_cast<double>(sides) / bounded);
+}
+
+void Voronoi_diagram::write(std::ostream& out) const {
+    auto write_array = [&out](const auto& values) {
+        out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(values[0]));
+    };
+    const uint32_t amounts[] = {static_cast<uint32_t>(sites.size()), static_cast<uint32_t>(vertices.size()),
+                                static_cast<uint32_t>(origins.size()), static_cast<uint32_t>(ray_sides.size())};
+    out.write("VOR1", 4);
+    out.write(reinterpret_cast<const char*>(amounts), sizeof(amounts));
+    std::vector<double> coordinates;
+    coordinates.reserve(2 * vertices.size());
+    for (const auto& v : vertices) coordinates.insert(coordinates.end(), {v.x, v.y});
+    write_array(coordinates);
+    std::vector<uint32_t> records;
+    records.reserve(4 * origins.size());
+    for (uint32_t e = 0; e < origins.size(); ++e) {
+        records.insert(records.end(), {origins[e], twins[e], nexts[e], cells[e]});
+    }
+    write_array(records);
+    write_array(first_edges);
+    write_array(areas);
+    write_array(ray_sides);
+}
+
+//queries over a Delaunay triangulation. Greedy walk on Delaunay graph goes to the neighbour nearest to the query
+//while it is nearer than the current site, and stops at the nearest site; walk starts from the site kept for
+//the query's cell of a uniform grid over sites (jump-and-walk). k nearest sites are found by the same graph:
+//the next nearest site is a neighbour of one of the previous ones. Sites are renumbered along Hilbert curve,
+//so neighbours in the graph are mostly near in memory
+class Delaunay_index {
+public:
+    static constexpr uint32_t no_triangle = UINT32_MAX;
+
+    Delaunay_index(std::vector<Point> _sites, const std::vector<Tetrad>& triangulation);
+
+    uint32_t find_nearest(const Point& query) const;
+    void find_nearest(const std::vector<Point>& queries, std::vector<uint32_t>& result,
+                      size_t threads_amount = 1) const;
+    //k nearest sites sorted by distance, equal sites are taken once
+    void find_k_nearest(const Point& query, size_t k, std::vector<uint32_t>& result) const;
+    //triangle which contains query, no_triangle if query is out of hull
+    uint32_t locate(const Point& query) const;
+    uint32_t corner(uint32_t triangle, uint32_t k) const { return numbers[corners[3 * triangle + k]]; }
+
+private:
+    uint32_t cell_of(const Point& query) const;
+    uint32_t find_nearest_site(const Point& query) const; //inner number of site
+
+    std::vector<Point> sites; //by inner numbers
+    std::vector<uint32_t> numbers; //number of site in input by inner number
+    std::vector<uint32_t> corners; //three dots of every triangle counterclockwise
+    std::vector<uint32_t> twins;
+    std::vector<uint32_t> triangle_of; //some triangle with the site
+    std::vector<uint32_t> neighbour_begins; //neighbours of site k are [neighbour_begins[k], neighbour_begins[k + 1])
+    std::vector<uint32_t> neighbours;
+
+    Point low;
+    double cells_per_unit = 0;
+    size_t grid_side = 0;
+    std::vector<uint32_t> grid; //site of every cell, cells without sites take a site of the nearest cell
+};
+
+Delaunay_index::Delaunay_index(std::vector<Point> _sites, const std::vector<Tetrad>& triangulation)
+        : triangle_of(_sites.size(), no_triangle) {
+    low = Point(INF, INF);
+    Point high(-INF, -INF);
+    for (const auto& site : _sites) {
+        low = Point(std::min(low.x, site.x), std::min(low.y, site.y));
+        high = Point(std::max(high.x, site.x), std::max(high.y, site.y));
+    }
+    double scale = 65535 / std::max({high.x - low.x, high.y - low.y, 1e-300});
+    std::vector<std::pair<uint32_t, uint32_t>> keys(_sites.size());
+    for (uint32_t i = 0; i < _sites.size(); ++i) {
+        keys[i] = {hilbert_index(static_cast<uint32_t>((_sites[i].x - low.x) * scale),
+                                 static_cast<uint32_t>((_sites[i].y - low.y) * scale)), i};
+    }
+    std::sort(keys.begin(), keys.end());
+    std::vector<uint32_t> inner_number(_sites.size());
+    sites.resize(_sites.size());
+    numbers.resize(_sites.size());
+    for (uint32_t k = 0; k < keys.size(); ++k) {
+        numbers[k] = keys[k].second;
+        inner_number[keys[k].second] = k;
+        sites[k] = _sites[keys[k].second];
+    }
+
+    const uint32_t triangles = static_cast<uint32_t>(triangulation.size());
+    corners.resize(3 * triangles);
+    for (uint32_t t = 0; t < triangles; ++t) {
+        uint32_t a = inner_number[triangulation[t].second];
+        uint32_t b = inner_number[triangulation[t].third];
+        uint32_t c = inner_number[triangulation[t].fourth];
+        if (orientation(sites[a], sites[b], sites[c]) < 0) std::swap(b, c);
+        corners[3 * t] = a;
+        corners[3 * t + 1] = b;
+        corners[3 * t + 2] = c;
+        triangle_of[a] = triangle_of[b] = triangle_of[c] = t;
+    }
+    twins = find_twin_sides(corners, sites.size());
+
+    //side u -> v gives neighbour v to u, hull side gives also u to v, because its twin is absent
+    neighbour_begins.assign(sites.size() + 1, 0);
+    for (uint32_t h = 0; h < corners.size(); ++h) {
+        uint32_t v = corners[h % 3 == 2 ? h - 2 : h + 1];
+        ++neighbour_begins[corners[h] + 1];
+        if (twins[h] == UINT32_MAX) ++neighbour_begins[v + 1];
+    }
+    for (size_t k = 1; k < neighbour_begins.size(); ++k) neighbour_begins[k] += neighbour_begins[k - 1];
+    neighbours.resize(neighbour_begins.back());
+    std::vector<uint32_t> filled(neighbour_begins.begin(), neighbour_begins.end() - 1);
+    for (uint32_t h = 0; h < corners.size(); ++h) {
+        uint32_t u = corners[h];
+        uint32_t v = corners[h % 3 == 2 ? h - 2 : h + 1];
+        neighbours[filled[u]++] = v;
+        if (twins[h] == UINT32_MAX) neighbours[filled[v]++] = u;
+    }
+
+    if (triangles == 0) return;
+    grid_side = std::max<size_t>(1, static_cast<size_t>(std::sqrt(sites.size() / 2.0)));
+    cells_per_unit = grid_side / std::max({high.x - low.x, high.y - low.y, 1e-300});
+    grid.assign(grid_side * grid_side, no_dot);
+    std::vector<double> distances(grid.size(), INF); //from site of cell to center of cell
+    for (uint32_t site = 0; site < sites.size(); ++site) {
+        if (triangle_of[site] == no_triangle) continue;
+        uint32_t cell = cell_of(sites[site]);
+        Point center = low + Point(cell % grid_side + 0.5, cell / grid_side + 0.5) * (1 / cells_per_unit);
+        double distance = (sites[site] - center).squared_length();
+        if (distance < distances[cell]) {
+            distances[cell] = distance;
+            grid[cell] = site;
+        }
+    }
+    std::vector<uint32_t> queue;
+    for (uint32_t cell = 0; cell < grid.size(); ++cell) {
+        if (grid[cell] != no_dot) queue.push_back(cell);
+    }
+    for (size_t k = 0; k < queue.size(); ++k) { //breadth-first search gives sites to empty cells
+        size_t x = queue[k] % grid_side, y = queue[k] / grid_side;
+        size_t cell = queue[k];
+        size_t around[4] = {x > 0 ? cell - 1 : cell, x + 1 < grid_side ? cell + 1 : cell,
+                            y > 0 ? cell - grid_side : cell, y + 1 < grid_side ? cell + grid_side : cell};
+        for (size_t other : around) {
+            if (grid[other] == no_dot) {
+                grid[other] = grid[cell];
+                queue.push_back(static_cast<uint32_t>(other));
+            }
         }
+    }
+}
 
-        insert_res = out_sides.insert(c);
-        if (!insert_res.second) {
-            out_sides.erase(c);
-            inner_side.insert(c);
+uint32_t Delaunay_index::cell_of(const Point& query) const {
+    auto coordinate = [this](double value) {
+        double cell = std::floor(value * cells_per_unit);
+        return static_cast<size_t>(std::min(std::max(cell, 0.0), static_cast<double>(grid_side - 1)));
+    };
+    return static_cast<uint32_t>(coordinate(query.y - low.y) * grid_side + coordinate(query.x - low.x));
+}
+
+uint32_t Delaunay_index::find_nearest(const Point& query) const {
+    uint32_t site = find_nearest_site(query);
+    return (site == no_dot ? no_dot : numbers[site]);
+}
+
+uint32_t Delaunay_index::find_nearest_site(const Point& query) const {
+    if (grid.empty()) { //no triangles, all sites are checked
+        uint32_t best = no_dot;
+        double best_distance = INF;
+        for (uint32_t site = 0; site < sites.size(); ++site) {
+            double distance = (sites[site] - query).squared_length();
+            if (distance < best_distance) {
+                best_distance = distance;
+                best = site;
+            }
         }
+        return best;
     }
-    Graph graph(number_of_dots);
-    for (auto& s : inner_side) {
-        graph.add_edge(s.first, s.second);
+
+    uint32_t current = grid[cell_of(query)];
+    double current_distance = (sites[current] - query).squared_length();
+    while (true) {
+        uint32_t best = current;
+        for (uint32_t k = neighbour_begins[current]; k < neighbour_begins[current + 1]; ++k) {
+            double distance = (sites[neighbours[k]] - query).squared_length();
+            if (distance < current_distance) {
+                current_distance = distance;
+                best = neighbours[k];
+            }
+        }
+        if (best == current) return current;
+        current = best;
     }
-    for (auto& s: out_sides) {
-        graph.delete_vertex(s.first);
-        graph.delete_vertex(s.second);
+}
+
+void Delaunay_index::find_nearest(const std::vector<Point>& queries, std::vector<uint32_t>& result,
+        size_t threads_amount) const {
+    result.resize(queries.size());
+    size_t parts = std::max<size_t>(1, std::min(threads_amount, queries.size() / 1024));
+    std::vector<std::thread> threads;
+    for (size_t k = 0; k < parts; ++k) {
+        threads.emplace_back([this, &queries, &result, k, parts]() {
+            for (size_t i = queries.size() * k / parts; i < queries.size() * (k + 1) / parts; ++i) {
+                result[i] = find_nearest(queries[i]);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+}
+
+void Delaunay_index::find_k_nearest(const Point& query, size_t k, std::vector<uint32_t>& result) const {
+    result.clear();
+    if (k == 0 || sites.empty()) return;
+    if (grid.empty()) { //no triangles, sites are popped by distance from a heap of all of them, equal ones once
+        using Candidate = std::tuple<double, double, double, uint32_t>; //distance, x, y, site
+        std::vector<Candidate> candidates;
+        candidates.reserve(sites.size());
+        for (uint32_t site = 0; site < sites.size(); ++site) {
+            candidates.emplace_back((sites[site] - query).squared_length(), sites[site].x, sites[site].y, site);
+        }
+        std::make_heap(candidates.begin(), candidates.end(), std::greater<Candidate>());
+        uint32_t last = no_dot;
+        while (!candidates.empty() && result.size() < k) {
+            std::pop_heap(candidates.begin(), candidates.end(), std::greater<Candidate>());
+            uint32_t site = std::get<3>(candidates.back());
+            candidates.pop_back();
+            if (last != no_dot && sites[site] == sites[last]) continue;
+            result.push_back(numbers[site]);
+            last = site;
+        }
+        return;
+    }
+    uint32_t nearest = find_nearest_site(query);
+
+    //site is seen in this search iff its stamp is the number of the search; stamps are per thread, so searches
+    //in parallel do not share them, and sites of other indices only make the array longer
+    thread_local std::vector<uint32_t> stamps;
+    thread_local uint32_t search = 0;
+    if (stamps.size() < sites.size()) stamps.resize(sites.size(), 0);
+    if (++search == 0) { //numbers of searches have wrapped around
+        std::fill(stamps.begin(), stamps.end(), 0);
+        search = 1;
+    }
+
+    using Candidate = std::pair<double, uint32_t>;
+    std::vector<Candidate> candidates = {{(sites[nearest] - query).squared_length(), nearest}}; //heap
+    stamps[nearest] = search;
+    while (!candidates.empty() && result.size() < k) {
+        std::pop_heap(candidates.begin(), candidates.end(), std::greater<Candidate>());
+        uint32_t site = candidates.back().second;
+        candidates.pop_back();
+        result.push_back(numbers[site]);
+        for (uint32_t j = neighbour_begins[site]; j < neighbour_begins[site + 1]; ++j) {
+            uint32_t neighbour = neighbours[j];
+            if (stamps[neighbour] == search) continue;
+            stamps[neighbour] = search;
+            candidates.emplace_back((sites[neighbour] - query).squared_length(), neighbour);
+            std::push_heap(candidates.begin(), candidates.end(), std::greater<Candidate>());
+        }
+    }
+}
+
+//walk from a triangle of the nearest site through sides which have query to the right
+uint32_t Delaunay_index::locate(const Point& query) const {
+    if (grid.empty()) return no_triangle;
+    uint32_t triangle = triangle_of[find_nearest_site(query)];
+    for (size_t steps = 0; steps < corners.size(); ++steps) {
+        bool is_moved = false;
+        for (uint32_t k = 0; k < 3 && !is_moved; ++k) {
+            uint32_t h = 3 * triangle + (k + steps) % 3;
+            uint32_t to = (h % 3 == 2 ? h - 2 : h + 1);
+            if (orientation(sites[corners[h]], sites[corners[to]], query) < 0) {
+                if (twins[h] == UINT32_MAX) return no_triangle;
+                triangle = twins[h] / 3;
+                is_moved = true;
+            }
+        }
+        if (!is_moved) return triangle;
+    }
+    return no_triangle;
+}
+
+//k-d tree over sites for comparison with Delaunay_index: node of range [from, to) is its median by axis
+class Kd_tree {
+public:
+    explicit Kd_tree(const std::vector<Point>& sites);
+    uint32_t find_nearest(const Point& query) const;
+
+private:
+    void build(size_t from, size_t to, size_t axis);
+    void find_nearest(size_t from, size_t to, size_t axis, const Point& query, size_t& best,
+                      double& best_distance) const;
+
+    std::vector<std::pair<Point, uint32_t>> nodes;
+};
+
+Kd_tree::Kd_tree(const std::vector<Point>& sites) : nodes(sites.size()) {
+    for (uint32_t i = 0; i < sites.size(); ++i) nodes[i] = {sites[i], i};
+    build(0, nodes.size(), 0);
+}
+
+void Kd_tree::build(size_t from, size_t to, size_t axis) {
+    if (to - from <= 1) return;
+    size_t middle = from + (to - from) / 2;
+    std::nth_element(nodes.begin() + from, nodes.begin() + middle, nodes.begin() + to,
+                     [axis](const std::pair<Point, uint32_t>& first, const std::pair<Point, uint32_t>& second) {
+                         return first.first[axis] < second.first[axis];
+                     });
+    build(from, middle, axis ^ 1);
+    build(middle + 1, to, axis ^ 1);
+}
+
+uint32_t Kd_tree::find_nearest(const Point& query) const {
+    if (nodes.empty()) return no_dot;
+    size_t best = 0;
+    double best_distance = INF;
+    find_nearest(0, nodes.size(), 0, query, best, best_distance);
+    return nodes[best].second;
+}
+
+void Kd_tree::find_nearest(size_t from, size_t to, size_t axis, const Point& query, size_t& best,
+        double& best_distance) const {
+    if (from >= to) return;
+    size_t middle = from + (to - from) / 2;
+    double distance = (nodes[middle].first - query).squared_length();
+    if (distance < best_distance) {
+        best_distance = distance;
+        best = middle;
+    }
+    double shift = query[axis] - nodes[middle].first[axis];
+    if (shift < 0) {
+        find_nearest(from, middle, axis ^ 1, query, best, best_distance);
+        if (shift * shift < best_distance) find_nearest(middle + 1, to, axis ^ 1, query, best, best_distance);
+    }
+    else {
+        find_nearest(middle + 1, to, axis ^ 1, query, best, best_distance);
+        if (shift * shift < best_distance) find_nearest(from, middle, axis ^ 1, query, best, best_distance);
     }
-    return std::make_pair(graph.sum_of_vertices_degrees(), out_sides.size());
 }
 
 template <class InputIterator>
-double average_number_of_sides_in_Voronoi_diagram(InputIterator&& begin, InputIterator&& end) {
+double average_number_of_sides_in_Voronoi_diagram(InputIterator&& begin, InputIterator&& end,
+        size_t threads_amount = 1, Delaunay_backend backend = Delaunay_backend::kinetic) {
     std::vector<Dot> dots;
-    std::set<Tetrad> triangulation;
-    Tetrad tmp(3);
     double x_, y_;
     int32_t counter = 0;
 
@@ -443,13 +2000,7 @@ double average_number_of_sides_in_Voronoi_diagram(InputIterator&& begin, InputIt
         ++counter;
     }
 
-    for (auto& d : dots) { //move dots a little to avoid perpendicular to Oxy situation
-        d.turn_around_zero(epsilon);
-    }
-    std::sort(dots.begin(), dots.end());
-
-    std::vector<Dot*> events = _build_lower_part_of_convex_hull(dots.begin(), dots.end(), dots.size());
-    write_answer(events, triangulation, true);
+    std::vector<Tetrad> triangulation = find_Delaunay_triangulation(dots, threads_amount, backend);
 
     std::pair<size_t, size_t> inner_sides = count_inner_Voronoi_diagram_sides(triangulation, counter);
     auto res = static_cast<double>(inner_sides.first);
@@ -461,9 +2012,445 @@ double average_number_of_sides_in_Voronoi_diagram(InputIterator&& begin, InputIt
         return 0;
 }
 
-int main() {
+template <class InputIterator>
+Voronoi_diagram find_Voronoi_diagram(InputIterator&& begin, InputIterator&& end, size_t threads_amount = 1,
+        Delaunay_backend backend = Delaunay_backend::kinetic) {
+    std::vector<Dot> dots;
+    std::vector<Point> sites;
+    while (begin != end) {
+        double x = *begin++;
+        double y = *begin++;
+        dots.emplace_back(x, y, project_onto_paraboloid(x, y), sites.size());
+        sites.emplace_back(x, y);
+    }
+
+    std::vector<Tetrad> triangulation = find_Delaunay_triangulation(dots, threads_amount, backend);
+    return Voronoi_diagram(std::move(sites), triangulation);
+}
+
+std::vector<Dot> random_dots(size_t n, std::mt19937& generator) {
+    std::uniform_real_distribution<double> coordinate(-1000, 1000);
+    std::vector<Dot> dots;
+    for (size_t i = 0; i < n; ++i) {
+        double x = coordinate(generator);
+        double y = coordinate(generator);
+        dots.emplace_back(x, y, project_onto_paraboloid(x, y), i);
+    }
+    return dots;
+}
+
+void benchmark_parallel_hull(size_t n, size_t threads_amount) {
+    std::mt19937 generator(2020);
+    std::vector<Dot> dots = random_dots(n, generator);
+
+    std::vector<Dot> sorted = dots;
+    std::sort(sorted.begin(), sorted.end());
+    auto start = std::chrono::steady_clock::now();
+    Kinetic_hull serial_hull(sorted);
+    auto serial_events = serial_hull.build();
+    std::chrono::duration<double, std::milli> serial_hull_time = std::chrono::steady_clock::now() - start;
+    start = std::chrono::steady_clock::now();
+    Kinetic_hull parallel_hull(sorted);
+    auto parallel_events = parallel_hull.build(forks_depth_for(threads_amount), default_parallel_cutoff);
+    std::chrono::duration<double, std::milli> parallel_hull_time = std::chrono::steady_clock::now() - start;
+    bool is_same_hull = (serial_events.second == parallel_events.second &&
+            std::equal(serial_events.first, serial_events.first + serial_events.second, parallel_events.first));
+
+    start = std::chrono::steady_clock::now();
+    std::vector<Tetrad> serial = find_Delaunay_triangulation(dots);
+    std::chrono::duration<double, std::milli> serial_time = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    std::vector<Tetrad> parallel = find_Delaunay_triangulation(dots, threads_amount);
+    std::chrono::duration<double, std::milli> parallel_time = std::chrono::steady_clock::now() - start;
+
+    bool is_same = (serial == parallel);
+    printf("%zu dots, %zu events, %zu triangles, event arena %.1f MB\n"
+           "hull, 1 thread: %.1f ms\nhull, %zu threads: %.1f ms\nsame events: %s\n"
+           "triangulation, 1 thread: %.1f ms\ntriangulation, %zu threads: %.1f ms\nsame triangulation: %s\n",
+           n, serial_events.second, serial.size(), serial_hull.arena_bytes() / 1e6, serial_hull_time.count(),
+           threads_amount, parallel_hull_time.count(), is_same_hull ? "yes" : "no", serial_time.count(),
+           threads_amount, parallel_time.count(), is_same ? "yes" : "no");
+}
+
+std::vector<Dot> clustered_dots(size_t n, std::mt19937& generator) {
+    std::uniform_real_distribution<double> center(-1000, 1000);
+    std::normal_distribution<double> offset(0, 5);
+    std::vector<Dot> dots;
+    double cx = 0, cy = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (i % 1000 == 0) {
+            cx = center(generator);
+            cy = center(generator);
+        }
+        double x = cx + offset(generator);
+        double y = cy + offset(generator);
+        dots.emplace_back(x, y, project_onto_paraboloid(x, y), i);
+    }
+    return dots;
+}
+
+//integer grid and a circle, moved by noise which is far less than distances between dots
+std::vector<Dot> near_degenerate_dots(size_t n, std::mt19937& generator) {
+    std::uniform_real_distribution<double> noise(-1e-6, 1e-6);
+    size_t side = static_cast<size_t>(std::sqrt(n / 2.0)) + 1;
+    std::vector<Dot> dots;
+    for (size_t i = 0; i < n; ++i) {
+        double x, y;
+        if (i % 2 == 0) {
+            x = static_cast<double>(i / 2 % side);
+            y = static_cast<double>(i / 2 / side);
+        } else {
+            double angle = 2 * M_PI * i / n;
+            x = side / 2.0 + side * std::cos(angle);
+            y = side / 2.0 + side * std::sin(angle);
+        }
+        x += noise(generator);
+        y += noise(generator);
+        dots.emplace_back(x, y, project_onto_paraboloid(x, y), i);
+    }
+    return dots;
+}
+
+void benchmark_backends(size_t n, size_t threads_amount) {
+    std::mt19937 generator(2020);
+    std::pair<const char*, std::vector<Dot>> sets[] = {{"uniform", random_dots(n, generator)},
+                                                       {"clustered", clustered_dots(n, generator)},
+                                                       {"near-degenerate", near_degenerate_dots(n, generator)}};
+    for (const auto& set : sets) {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<Tetrad> kinetic = find_Delaunay_triangulation(set.second, threads_amount);
+        std::chrono::duration<double, std::milli> kinetic_time = std::chrono::steady_clock::now() - start;
+        start = std::chrono::steady_clock::now();
+        std::vector<Tetrad> incremental = find_Delaunay_triangulation_incrementally(set.second);
+        std::chrono::duration<double, std::milli> incremental_time = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        std::vector<Point> points(n);
+        for (const auto& d : set.second) points[d.number] = Point(d.current.x, d.current.y);
+        bool is_valid = is_Delaunay_triangulation(kinetic, points);
+        std::chrono::duration<double, std::milli> check_time = std::chrono::steady_clock::now() - start;
+
+        auto kinetic_sides = count_inner_Voronoi_diagram_sides(kinetic, n);
+        auto incremental_sides = count_inner_Voronoi_diagram_sides(incremental, n);
+        auto sorted_corners = [](std::vector<Tetrad> triangulation) { //backends orient triangles differently
+            for (auto& t : triangulation) {
+                std::array<uint32_t, 3> corners = {t.second, t.third, t.fourth};
+                std::sort(corners.begin(), corners.end());
+                t.second = corners[0], t.third = corners[1], t.fourth = corners[2];
+            }
+            std::sort(triangulation.begin(), triangulation.end());
+            return triangulation;
+        };
+        printf("%s, %zu dots\nkinetic, %zu threads: %.1f ms, %zu triangles, answer %.10f\n"
+               "incremental: %.1f ms, %zu triangles, answer %.10f\nkinetic is Delaunay: %s (checked in %.1f ms)\n"
+               "same triangulation: %s\n",
+               set.first, n, threads_amount, kinetic_time.count(), kinetic.size(),
+               static_cast<double>(kinetic_sides.first) / (n - kinetic_sides.second), incremental_time.count(),
+               incremental.size(), static_cast<double>(incremental_sides.first) / (n - incremental_sides.second),
+               is_valid ? "yes" : "no", check_time.count(),
+               sorted_corners(kinetic) == sorted_corners(incremental) ? "yes" : "no");
+    }
+}
+
+//stdin has coordinates x y z of dots, faces are written as "3 a b c" with numbers of dots in input
+void run_convex_hull(std::istream& in) {
+    std::vector<Dot> dots;
+    double x, y, z;
+    while (in >> x >> y >> z) dots.emplace_back(x, y, z, dots.size());
+    std::vector<Tetrad> faces = find_convex_hull(dots);
+    std::cout << faces.size() << "\n";
+    for (auto& face : faces) face.print();
+}
+
+//random dots on a sphere and in a ball, and dots of an integer lattice in a cube and on the surface of a box,
+//where many dots are in the planes of faces
+void benchmark_convex_hull(size_t n) {
+    std::mt19937 generator(2020);
+    std::normal_distribution<double> coordinate(0, 1);
+    std::vector<Dot> sphere;
+    std::vector<Dot> ball;
+    for (size_t i = 0; i < n; ++i) {
+        Vector v(coordinate(generator), coordinate(generator), coordinate(generator));
+        v *= 1 / v.length();
+        sphere.emplace_back(v.x, v.y, v.z, i);
+        v *= std::cbrt(std::uniform_real_distribution<double>(0, 1)(generator));
+        ball.emplace_back(v.x, v.y, v.z, i);
+    }
+    std::vector<Dot> lattice;
+    std::vector<Dot> box;
+    const int side = static_cast<int>(std::cbrt(static_cast<double>(n)));
+    std::uniform_int_distribution<int> cell(0, side);
+    for (size_t i = 0; i < n; ++i) {
+        int x = cell(generator), y = cell(generator), z = cell(generator);
+        lattice.emplace_back(x, y, z, i);
+        int& on_face = (i % 3 == 0 ? x : (i % 3 == 1 ? y : z));
+        on_face = (i % 2 == 0 ? 0 : side);
+        box.emplace_back(x, 2 * y, 3 * z, i);
+    }
+
+    std::pair<const char*, const std::vector<Dot>*> sets[] = {{"sphere", &sphere}, {"ball", &ball},
+                                                              {"lattice", &lattice}, {"box surface", &box}};
+    for (const auto& set : sets) {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<Tetrad> faces = find_convex_hull(*set.second);
+        std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+        printf("%s, %zu dots, %zu faces\nhull: %.1f ms\nclosed: %s\n", set.first, n, faces.size(), time.count(),
+               is_closed_surface(faces) ? "yes" : "no");
+    }
+}
+
+//commands of stdin: "+ x y" inserts dot (dots are numbered from 0 in order of these commands), "- k" removes
+//dot number k, "?" prints mean number of sides of bounded Voronoi cells
+void run_dynamic(std::istream& in) {
+    Incremental_Delaunay triangulation{std::vector<Point>()};
+    std::vector<uint32_t> numbers; //number of command -> number of dot in triangulation
+    std::string command;
+    while (in >> command) {
+        if (command == "+") {
+            double x, y;
+            in >> x >> y;
+            numbers.push_back(triangulation.insert(Point(x, y)));
+        }
+        else if (command == "-") {
+            size_t k;
+            in >> k;
+            if (k < numbers.size()) triangulation.remove(numbers[k]);
+        }
+        else if (command == "?") {
+            printf("%.10f\n", triangulation.average_number_of_sides());
+        }
+    }
+}
+
+void benchmark_dynamic(size_t n, size_t updates) {
+    std::mt19937 generator(2020);
+    std::uniform_real_distribution<double> coordinate(-1000, 1000);
+    std::vector<Point> points(n);
+    for (auto& point : points) point = Point(coordinate(generator), coordinate(generator));
+
+    auto start = std::chrono::steady_clock::now();
+    Incremental_Delaunay triangulation(points);
+    std::chrono::duration<double, std::milli> build_time = std::chrono::steady_clock::now() - start;
+
+    std::vector<uint32_t> alive(n);
+    for (uint32_t i = 0; i < n; ++i) alive[i] = i;
+    start = std::chrono::steady_clock::now();
+    for (size_t k = 0; k < updates; ++k) {
+        if (k % 2 == 0 && !alive.empty()) {
+            size_t i = generator() % alive.size();
+            triangulation.remove(alive[i]);
+            alive[i] = alive.back();
+            alive.pop_back();
+        }
+        else {
+            uint32_t dot = triangulation.insert(Point(coordinate(generator), coordinate(generator)));
+            if (dot != no_dot) alive.push_back(dot);
+        }
+    }
+    std::chrono::duration<double, std::micro> update_time = std::chrono::steady_clock::now() - start;
+
+    std::vector<Tetrad> triangles = triangulation.triangles();
+    auto inner_sides = count_inner_Voronoi_diagram_sides(triangles, n + updates);
+    double rebuilt = static_cast<double>(inner_sides.first) / (triangulation.size() - inner_sides.second);
+
+    //small lattice with repeated dots: every round starts with dots on one line, so triangulation is rebuilt
+    //while they are collinear, then it leaves the line; a dot is inserted iff no alive dot is equal to it,
+    //and the answer is recounted after every update
+    constexpr size_t rounds = 2000;
+    constexpr size_t round_updates = 60;
+    constexpr size_t collinear_updates = 20;
+    std::uniform_int_distribution<int> lattice_coordinate(-3, 3);
+    size_t mismatches = 0;
+    for (size_t round = 0; round < rounds; ++round) {
+        Incremental_Delaunay lattice{std::vector<Point>()};
+        std::vector<uint32_t> lattice_alive;
+        std::vector<Point> lattice_points;
+        for (size_t k = 0; k < round_updates; ++k) {
+            if (k % 3 == 2 && !lattice_alive.empty()) {
+                size_t i = generator() % lattice_alive.size();
+                lattice.remove(lattice_alive[i]);
+                lattice_alive[i] = lattice_alive.back();
+                lattice_alive.pop_back();
+                lattice_points[i] = lattice_points.back();
+                lattice_points.pop_back();
+            }
+            else {
+                int x = lattice_coordinate(generator);
+                Point point(x, k < collinear_updates ? x : lattice_coordinate(generator));
+                bool is_repeated = std::find(lattice_points.begin(), lattice_points.end(), point) !=
+                                   lattice_points.end();
+                uint32_t dot = lattice.insert(point);
+                mismatches += (is_repeated != (dot == no_dot));
+                if (dot != no_dot) {
+                    lattice_alive.push_back(dot);
+                    lattice_points.push_back(point);
+                }
+            }
+            auto lattice_sides = count_inner_Voronoi_diagram_sides(lattice.triangles(), round_updates);
+            size_t inner_dots = lattice.size() - lattice_sides.second;
+            double recounted = (inner_dots == 0 ? 0 : static_cast<double>(lattice_sides.first) / inner_dots);
+            mismatches += (lattice.size() != lattice_alive.size() ||
+                           std::fabs(lattice.average_number_of_sides() - recounted) > 1e-9);
+        }
+    }
+    printf("%zu dots\nbuild: %.1f ms\n%zu updates: %.2f us per update\nanswer %.10f, recounted %.10f\n"
+           "%zu rounds of updates on lattice with repeated and collinear dots, mismatches: %zu\n",
+           n, build_time.count(), updates, update_time.count() / updates, triangulation.average_number_of_sides(),
+           rebuilt, rounds, mismatches);
+}
+
+void benchmark_queries(size_t n, size_t threads_amount) {
+    std::mt19937 generator(2020);
+    std::uniform_real_distribution<double> coordinate(-1000, 1000);
+    std::vector<Dot> dots;
+    std::vector<Point> sites;
+    std::vector<Point> queries(n);
+    for (size_t i = 0; i < n; ++i) {
+        sites.emplace_back(coordinate(generator), coordinate(generator));
+        dots.emplace_back(sites[i].x, sites[i].y, project_onto_paraboloid(sites[i].x, sites[i].y), i);
+    }
+    for (auto& query : queries) query = Point(coordinate(generator), coordinate(generator));
+
+    auto start = std::chrono::steady_clock::now();
+    Delaunay_index index(sites, find_Delaunay_triangulation_incrementally(dots));
+    std::chrono::duration<double, std::milli> index_time = std::chrono::steady_clock::now() - start;
+    start = std::chrono::steady_clock::now();
+    Kd_tree tree(sites);
+    std::chrono::duration<double, std::milli> tree_time = std::chrono::steady_clock::now() - start;
+
+    auto measure = [&queries](auto&& query) {
+        auto start = std::chrono::steady_clock::now();
+        query();
+        std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+        return queries.size() / time.count() / 1e6;
+    };
+    std::vector<uint32_t> serial, parallel, baseline(n), located(n);
+    double serial_speed = measure([&]() { index.find_nearest(queries, serial); });
+    double parallel_speed = measure([&]() { index.find_nearest(queries, parallel, threads_amount); });
+    double tree_speed = measure([&]() {
+        for (size_t i = 0; i < n; ++i) baseline[i] = tree.find_nearest(queries[i]);
+    });
+    double locate_speed = measure([&]() {
+        for (size_t i = 0; i < n; ++i) located[i] = index.locate(queries[i]);
+    });
+    std::vector<uint32_t> k_nearest;
+    size_t k_nearest_sum = 0;
+    double k_nearest_speed = measure([&]() {
+        for (const auto& query : queries) {
+            index.find_k_nearest(query, 8, k_nearest);
+            k_nearest_sum += k_nearest.back();
+        }
+    });
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < n; ++i) {
+        mismatches += ((sites[serial[i]] - queries[i]).squared_length() !=
+                       (sites[baseline[i]] - queries[i]).squared_length()) || serial[i] != parallel[i];
+    }
+
+    //repeated sites on one line give no triangles, k nearest are distinct sites sorted by distance
+    constexpr size_t line_queries = 1000;
+    constexpr size_t line_k = 8;
+    std::vector<Point> line;
+    for (size_t i = 0; i < 64; ++i) {
+        double t = generator() % 16;
+        line.emplace_back(t, 2 * t);
+    }
+    std::vector<Point> distinct = line;
+    std::sort(distinct.begin(), distinct.end(), [](const Point& first, const Point& second) {
+        return first.x < second.x || (first.x == second.x && first.y < second.y);
+    });
+    distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+    Delaunay_index line_index(line, std::vector<Tetrad>());
+    std::uniform_real_distribution<double> line_coordinate(-5, 40);
+    for (size_t q = 0; q < line_queries; ++q) {
+        Point query(line_coordinate(generator), line_coordinate(generator));
+        std::vector<double> distances;
+        for (const Point& site : distinct) distances.push_back((site - query).squared_length());
+        std::sort(distances.begin(), distances.end());
+        distances.resize(std::min(line_k, distances.size()));
+        line_index.find_k_nearest(query, line_k, k_nearest);
+        mismatches += (k_nearest.size() != distances.size());
+        for (size_t i = 0; i < std::min(k_nearest.size(), distances.size()); ++i) {
+            mismatches += ((line[k_nearest[i]] - query).squared_length() != distances[i]);
+        }
+    }
+    printf("%zu sites, %zu queries\nbuild: triangulation and Delaunay index %.1f ms, k-d tree %.1f ms\n"
+           "nearest, Delaunay index, 1 thread: %.2f M/s\nnearest, Delaunay index, %zu threads: %.2f M/s\n"
+           "nearest, k-d tree, 1 thread: %.2f M/s\nmismatches: %zu\nlocate: %.2f M/s\n8 nearest: %.2f M/s\n",
+           n, n, index_time.count(), tree_time.count(), serial_speed, threads_amount, parallel_speed, tree_speed,
+           mismatches, locate_speed, k_nearest_speed);
+}
+
+//usage: module3_solutionD [--threads k] [--backend kinetic|incremental] [--export-voronoi file] [--dynamic]
+//                          [--hull] [--bench n] [--bench-backends n] [--bench-dynamic n] [--bench-hull n]
+//                          [--bench-queries n]
+int main(int argc, char* argv[]) {
+    size_t threads_amount = 1;
+    size_t bench_size = 0;
+    size_t bench_backends_size = 0;
+    size_t bench_dynamic_size = 0;
+    size_t bench_hull_size = 0;
+    size_t bench_queries_size = 0;
+    Delaunay_backend backend = Delaunay_backend::kinetic;
+    std::string voronoi_path;
+    if (argc > 1 && std::string(argv[1]) == "--dynamic") {
+        run_dynamic(std::cin);
+        return 0;
+    }
+    bool is_hull = (argc > 1 && std::string(argv[1]) == "--hull"); //the only flag without value
+    for (int k = 1 + is_hull; k + 1 < argc; k += 2) {
+        if (std::string(argv[k]) == "--threads") threads_amount = std::stoul(argv[k + 1]);
+        else if (std::string(argv[k]) == "--bench") bench_size = std::stoul(argv[k + 1]);
+        else if (std::string(argv[k]) == "--bench-backends") bench_backends_size = std::stoul(argv[k + 1]);
+        else if (std::string(argv[k]) == "--bench-dynamic") bench_dynamic_size = std::stoul(argv[k + 1]);
+        else if (std::string(argv[k]) == "--bench-hull") bench_hull_size = std::stoul(argv[k + 1]);
+        else if (std::string(argv[k]) == "--bench-queries") bench_queries_size = std::stoul(argv[k + 1]);
+        else if (std::string(argv[k]) == "--backend" && std::string(argv[k + 1]) == "incremental")
+            backend = Delaunay_backend::incremental;
+        else if (std::string(argv[k]) == "--export-voronoi") voronoi_path = argv[k + 1];
+    }
+    if (threads_amount == 0) threads_amount = std::max<unsigned>(1, std::thread::hardware_concurrency());
+    if (bench_size > 0) {
+        benchmark_parallel_hull(bench_size, threads_amount);
+        return 0;
+    }
+    if (bench_backends_size > 0) {
+        benchmark_backends(bench_backends_size, threads_amount);
+        return 0;
+    }
+    if (is_hull) {
+        run_convex_hull(std::cin);
+        return 0;
+    }
+    if (bench_hull_size > 0) {
+        benchmark_convex_hull(bench_hull_size);
+        return 0;
+    }
+    if (bench_queries_size > 0) {
+        benchmark_queries(bench_queries_size, threads_amount);
+        return 0;
+    }
+    if (bench_dynamic_size > 0) {
+        benchmark_dynamic(bench_dynamic_size, 100000);
+        return 0;
+    }
+    if (!voronoi_path.empty()) {
+        Voronoi_diagram diagram = find_Voronoi_diagram(std::istream_iterator<double>(std::cin),
+                std::istream_iterator<double>(), threads_amount, backend);
+        std::ofstream out(voronoi_path, std::ios::binary);
+        diagram.write(out);
+        if (!out) {
+            std::cerr << "can not write " << voronoi_path << "\n";
+            return 1;
+        }
+        printf("%.10f", diagram.average_number_of_sides());
+        return 0;
+    }
+
     double answer = average_number_of_sides_in_Voronoi_diagram(std::istream_iterator<double>(std::cin),
-            std::istream_iterator<double>());
+            std::istream_iterator<double>(), threads_amount, backend);
     printf("%.10f", answer);
     return 0;
 }
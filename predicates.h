@@ -0,0 +1,275 @@
+/*Общие для задач по вычислительной геометрии предикаты: ориентация тройки точек и положение точки относительно
+окружности. Знак считается точно: сначала в double с оценкой погрешности, и только если она не позволяет
+определить знак - точно в арифметике разложений (expansion arithmetic Шевчука). Для точек на одной окружности
+есть вариант с символическим возмущением (Simulation of Simplicity).*/
+
+#ifndef PREDICATES_H
+#define PREDICATES_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include "geometry.h"
+
+namespace geometry {
+
+//error-free transformations and arithmetic of expansions: an expansion is an array of nonoverlapping doubles
+//which increase by magnitude, its value is their exact sum; zero components are not stored
+namespace exact {
+
+constexpr double epsilon = 1.0 / 9007199254740992.0; //2^-53, half of the distance from 1 to the next double
+
+inline void two_sum(double a, double b, double& sum, double& error) {
+    sum = a + b;
+    double b_part = sum - a;
+    double a_part = sum - b_part;
+    error = (a - a_part) + (b - b_part);
+}
+
+inline void fast_two_sum(double a, double b, double& sum, double& error) { //|a| >= |b|
+    sum = a + b;
+    error = b - (sum - a);
+}
+
+inline void two_product(double a, double b, double& product, double& error) {
+    product = a * b;
+    error = std::fma(a, b, -product);
+}
+
+//h = e + f, h has elen + flen places
+inline std::size_t expansion_sum(const double* e, std::size_t elen, const double* f, std::size_t flen, double* h) {
+    std::size_t i = 0;
+    std::size_t j = 0;
+    auto next = [&]() { //components of both expansions by increasing magnitude
+        if (j == flen || (i < elen && (f[j] > e[i]) == (f[j] > -e[i]))) return e[i++];
+        return f[j++];
+    };
+    std::size_t size = 0;
+    double q = next();
+    while (i < elen || j < flen) {
+        double sum, error;
+        two_sum(q, next(), sum, error);
+        if (error != 0) h[size++] = error;
+        q = sum;
+    }
+    if (q != 0 || size == 0) h[size++] = q;
+    return size;
+}
+
+//h = e * b, h has 2 * elen places
+inline std::size_t scale_expansion(const double* e, std::size_t elen, double b, double* h) {
+    std::size_t size = 0;
+    double q, error;
+    two_product(e[0], b, q, error);
+    if (error != 0) h[size++] = error;
+    for (std::size_t i = 1; i < elen; ++i) {
+        double product, product_error, sum;
+        two_product(e[i], b, product, product_error);
+        two_sum(q, product_error, sum, error);
+        if (error != 0) h[size++] = error;
+        fast_two_sum(product, sum, q, error);
+        if (error != 0) h[size++] = error;
+    }
+    if (q != 0 || size == 0) h[size++] = q;
+    return size;
+}
+
+//e += f, buffer has elen + flen places
+inline void add(double* e, std::size_t& elen, const double* f, std::size_t flen, double* buffer) {
+    elen = expansion_sum(e, elen, f, flen, buffer);
+    std::copy(buffer, buffer + elen, e);
+}
+
+//value of expansion rounded to double: the greatest component is greater than sum of others, so sign is exact
+inline double estimate(const double* e, std::size_t elen) {
+    double result = 0;
+    for (std::size_t i = 0; i < elen; ++i) result += e[i];
+    return result;
+}
+
+//determinant |ax ay 1; bx by 1; cx cy 1| = ax*by - ay*bx + bx*cy - by*cx + cx*ay - cy*ax, h has 12 places
+inline std::size_t orient2d(double ax, double ay, double bx, double by, double cx, double cy, double* h) {
+    const double factors[6][2] = {{ax, by}, {-ay, bx}, {bx, cy}, {-by, cx}, {cx, ay}, {-cy, ax}};
+    std::size_t size = 1;
+    h[0] = 0;
+    for (const auto& factor : factors) {
+        double product[2];
+        two_product(factor[0], factor[1], product[1], product[0]);
+        const std::size_t product_size = (product[0] != 0 ? 2 : 1);
+        double buffer[13];
+        add(h, size, product + 2 - product_size, product_size, buffer);
+    }
+    return size;
+}
+
+inline double orient2d(double ax, double ay, double bx, double by, double cx, double cy) {
+    double h[12];
+    return estimate(h, orient2d(ax, ay, bx, by, cx, cy, h));
+}
+
+//determinant |x y w 1| of rows a, b, c, d, where w of row r is the expansion lifts[r] of lift_sizes[r] <= 4 places;
+//it is expanded by the column of w: w of every row is multiplied by orient2d of three other rows
+inline double lifted_determinant(const double (&rows)[4][2], const double (&lifts)[4][4],
+        const std::size_t (&lift_sizes)[4]) {
+    constexpr std::size_t term_places = 2 * 12 * 4;
+    double total[4 * term_places + 1] = {0};
+    std::size_t total_size = 1;
+    for (std::size_t r = 0; r < 4; ++r) {
+        const double (&p)[2] = rows[r == 0 ? 1 : 0];
+        const double (&q)[2] = rows[r <= 1 ? 2 : 1];
+        const double (&s)[2] = rows[r <= 2 ? 3 : 2];
+        double minor[12];
+        const std::size_t minor_size = orient2d(p[0], p[1], q[0], q[1], s[0], s[1], minor);
+
+        double term[term_places + 1] = {0};
+        std::size_t term_size = 1;
+        for (std::size_t k = 0; k < lift_sizes[r]; ++k) {
+            double scaled[24];
+            double buffer[term_places + 1];
+            const double lift = (r % 2 == 1 ? -lifts[r][k] : lifts[r][k]);
+            add(term, term_size, scaled, scale_expansion(minor, minor_size, lift, scaled), buffer);
+        }
+        double buffer[4 * term_places + 1];
+        add(total, total_size, term, term_size, buffer);
+    }
+    return estimate(total, total_size);
+}
+
+//lifts are x^2 + y^2 of rows
+inline double incircle(const double (&rows)[4][2]) {
+    double lifts[4][4];
+    std::size_t lift_sizes[4];
+    for (std::size_t r = 0; r < 4; ++r) {
+        double squares[2][2];
+        two_product(rows[r][0], rows[r][0], squares[0][1], squares[0][0]);
+        two_product(rows[r][1], rows[r][1], squares[1][1], squares[1][0]);
+        lift_sizes[r] = expansion_sum(squares[0], 2, squares[1], 2, lifts[r]);
+    }
+    return lifted_determinant(rows, lifts, lift_sizes);
+}
+
+//lifts are z of rows, so it is |x y z 1|
+inline double orient3d(const double (&rows)[4][3]) {
+    double plane[4][2];
+    double lifts[4][4];
+    std::size_t lift_sizes[4];
+    for (std::size_t r = 0; r < 4; ++r) {
+        plane[r][0] = rows[r][0];
+        plane[r][1] = rows[r][1];
+        lifts[r][0] = rows[r][2];
+        lift_sizes[r] = 1;
+    }
+    return lifted_determinant(plane, lifts, lift_sizes);
+}
+
+}
+
+//bounds of relative error of the computation in double for the filters, Shewchuk's ccwerrboundA and iccerrboundA
+constexpr double orient2d_error_bound = (3 + 16 * exact::epsilon) * exact::epsilon;
+constexpr double incircle_error_bound = (10 + 96 * exact::epsilon) * exact::epsilon;
+constexpr double orient3d_error_bound = (7 + 56 * exact::epsilon) * exact::epsilon; //o3derrboundA
+
+//> 0 if a, b, c go counterclockwise, < 0 if clockwise, 0 if they are on one line; the sign is exact
+inline double orient2d(const Vector<double, 2>& a, const Vector<double, 2>& b, const Vector<double, 2>& c) {
+    double left = (a.x - c.x) * (b.y - c.y);
+    double right = (a.y - c.y) * (b.x - c.x);
+    double det = left - right;
+    double bound = orient2d_error_bound * (std::fabs(left) + std::fabs(right));
+    if (std::fabs(det) >= bound) return det;
+    return exact::orient2d(a.x, a.y, b.x, b.y, c.x, c.y);
+}
+
+//> 0 if d is inside the circle through counterclockwise a, b, c, < 0 if outside, 0 if on it; the sign is exact
+inline double incircle(const Vector<double, 2>& a, const Vector<double, 2>& b, const Vector<double, 2>& c,
+        const Vector<double, 2>& d) {
+    double adx = a.x - d.x, ady = a.y - d.y;
+    double bdx = b.x - d.x, bdy = b.y - d.y;
+    double cdx = c.x - d.x, cdy = c.y - d.y;
+    double bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+    double cdxady = cdx * ady, adxcdy = adx * cdy;
+    double adxbdy = adx * bdy, bdxady = bdx * ady;
+    double alift = adx * adx + ady * ady;
+    double blift = bdx * bdx + bdy * bdy;
+    double clift = cdx * cdx + cdy * cdy;
+    double det = alift * (bdxcdy - cdxbdy) + blift * (cdxady - adxcdy) + clift * (adxbdy - bdxady);
+    double permanent = (std::fabs(bdxcdy) + std::fabs(cdxbdy)) * alift +
+                       (std::fabs(cdxady) + std::fabs(adxcdy)) * blift +
+                       (std::fabs(adxbdy) + std::fabs(bdxady)) * clift;
+    double bound = incircle_error_bound * permanent;
+    if (std::fabs(det) >= bound) return det;
+    return exact::incircle({{a.x, a.y}, {b.x, b.y}, {c.x, c.y}, {d.x, d.y}});
+}
+
+//> 0 if d is below the plane of a, b, c, which go counterclockwise if we look from above, < 0 if d is above,
+//0 if all four are in one plane; the sign is exact
+inline double orient3d(const Vector<double, 3>& a, const Vector<double, 3>& b, const Vector<double, 3>& c,
+        const Vector<double, 3>& d) {
+    double adx = a.x - d.x, ady = a.y - d.y, adz = a.z - d.z;
+    double bdx = b.x - d.x, bdy = b.y - d.y, bdz = b.z - d.z;
+    double cdx = c.x - d.x, cdy = c.y - d.y, cdz = c.z - d.z;
+    double bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+    double cdxady = cdx * ady, adxcdy = adx * cdy;
+    double adxbdy = adx * bdy, bdxady = bdx * ady;
+    double det = adz * (bdxcdy - cdxbdy) + bdz * (cdxady - adxcdy) + cdz * (adxbdy - bdxady);
+    double permanent = (std::fabs(bdxcdy) + std::fabs(cdxbdy)) * std::fabs(adz) +
+                       (std::fabs(cdxady) + std::fabs(adxcdy)) * std::fabs(bdz) +
+                       (std::fabs(adxbdy) + std::fabs(bdxady)) * std::fabs(cdz);
+    double bound = orient3d_error_bound * permanent;
+    if (std::fabs(det) >= bound) return det;
+    return exact::orient3d({{a.x, a.y, a.z}, {b.x, b.y, b.z}, {c.x, c.y, c.z}, {d.x, d.y, d.z}});
+}
+
+//static filter: bounds of errors for all dots whose coordinates differ by at most width, they are checked before
+//the bounds of the arguments themselves; both are doubled to cover rounding of the differences
+struct Static_error_bounds {
+    Static_error_bounds() = default;
+    explicit Static_error_bounds(double width)
+            : orient(2 * orient2d_error_bound * 2 * width * width)
+            , circle(2 * incircle_error_bound * 12 * width * width * width * width) { }
+
+    double orient = std::numeric_limits<double>::infinity();
+    double circle = std::numeric_limits<double>::infinity();
+};
+
+inline double orient2d(const Vector<double, 2>& a, const Vector<double, 2>& b, const Vector<double, 2>& c,
+        const Static_error_bounds& bounds) {
+    double det = (a.x - c.x) * (b.y - c.y) - (a.y - c.y) * (b.x - c.x);
+    if (std::fabs(det) >= bounds.orient) return det;
+    return orient2d(a, b, c);
+}
+
+inline double incircle(const Vector<double, 2>& a, const Vector<double, 2>& b, const Vector<double, 2>& c,
+        const Vector<double, 2>& d, const Static_error_bounds& bounds) {
+    double adx = a.x - d.x, ady = a.y - d.y;
+    double bdx = b.x - d.x, bdy = b.y - d.y;
+    double cdx = c.x - d.x, cdy = c.y - d.y;
+    double det = (adx * adx + ady * ady) * (bdx * cdy - cdx * bdy) + (bdx * bdx + bdy * bdy) * (cdx * ady - adx * cdy) +
+                 (cdx * cdx + cdy * cdy) * (adx * bdy - bdx * ady);
+    if (std::fabs(det) >= bounds.circle) return det;
+    return incircle(a, b, c, d);
+}
+
+//incircle with lifts x^2 + y^2 of dots raised by infinitely small amounts, the smaller number of dot is, the
+//more it is raised: 0 only if all four dots are on one line, so dots on one circle get a unique triangulation;
+//dots are not moved on the plane, so orient2d needs no perturbation together with it
+inline double incircle_perturbed(const Vector<double, 2>& a, const Vector<double, 2>& b,
+        const Vector<double, 2>& c, const Vector<double, 2>& d, std::size_t a_number, std::size_t b_number,
+        std::size_t c_number, std::size_t d_number, const Static_error_bounds& bounds = Static_error_bounds()) {
+    double det = incircle(a, b, c, d, bounds);
+    if (det != 0) return det;
+
+    const Vector<double, 2>* rows[4] = {&a, &b, &c, &d};
+    std::size_t order[4] = {0, 1, 2, 3};
+    const std::size_t numbers[4] = {a_number, b_number, c_number, d_number};
+    std::sort(order, order + 4, [&numbers](std::size_t i, std::size_t j) { return numbers[i] < numbers[j]; });
+    for (std::size_t r : order) { //determinant is linear in lift of row r with coefficient +-orient2d of others
+        double minor = orient2d(*rows[r == 0 ? 1 : 0], *rows[r <= 1 ? 2 : 1], *rows[r <= 2 ? 3 : 2]);
+        if (minor != 0) return (r % 2 == 0 ? minor : -minor);
+    }
+    return 0;
+}
+
+}
+
+#endif //PREDICATES_H
@@ -12,36 +12,89 @@
 #include <queue>
 #include <memory>
 #include <array>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <unordered_map>
+#include <stdexcept>
+#include <cstring>
+#include <iterator>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 constexpr char first_letter = 'a';
-constexpr size_t alphabet_size = 26;
+constexpr size_t bytes_amount = 256;
 
 class Aho_Korasick;
+class Compiled_automaton;
+
+//compresses bytes which are used in patterns to dense codes 1, 2, ..., every other byte gets code no_match,
+//so transition tables are as small as the effective alphabet
+class Alphabet {
+public:
+    static constexpr uint16_t no_match = 0;
+
+    Alphabet() = default;
+    explicit Alphabet(const std::vector<std::pair<std::string_view, size_t>>& subpatterns);
+
+    uint16_t operator[](char c) const {
+        return codes[static_cast<unsigned char>(c)];
+    }
+
+    std::size_t size() const { //amount of codes including no_match
+        return codes_amount;
+    }
+
+private:
+    std::array<uint16_t, bytes_amount> codes = {};
+    std::size_t codes_amount = 1;
+};
+
+Alphabet::Alphabet(const std::vector<std::pair<std::string_view, size_t>>& subpatterns) {
+    std::array<bool, bytes_amount> is_used = {};
+    for (auto& subpattern : subpatterns) {
+        for (auto c : subpattern.first) {
+            is_used[static_cast<unsigned char>(c)] = true;
+        }
+    }
+    for (size_t c = 0; c < bytes_amount; ++c) { //codes keep the order of bytes
+        if (is_used[c]) codes[c] = codes_amount++;
+    }
+}
 
 class Trie {
 public:
     Trie(const std::vector<std::pair<std::string_view, size_t>>& subpatterns);
 
     friend class Aho_Korasick;
+    friend class Compiled_automaton;
 private:
     struct Node {
-        Node(char _letter, bool _is_terminate)
+        Node(uint16_t _letter, bool _is_terminate, size_t alphabet_size)
                 : letter(_letter)
-                , is_terminate(_is_terminate) { }
-        Node(char _letter, bool _is_terminate, std::shared_ptr<Node> _parent)
+                , is_terminate(_is_terminate)
+                , next_vertices(alphabet_size) { }
+        Node(uint16_t _letter, bool _is_terminate, size_t alphabet_size, std::shared_ptr<Node> _parent)
                 : letter(_letter)
                 , is_terminate(_is_terminate)
+                , next_vertices(alphabet_size)
                 , parent(_parent) { }
 
-        char letter = -1;
+        uint16_t letter = Alphabet::no_match; //code of letter on the edge from parent
         bool is_terminate = false;
         std::vector<size_t> index_of_pattern;
-        std::array<std::shared_ptr<Node>, alphabet_size> next_vertices;
+        std::vector<std::shared_ptr<Node>> next_vertices; //indexed by codes of alphabet
         std::weak_ptr<Node> parent;
         std::weak_ptr<Node> suf_link;
         std::weak_ptr<Node> short_suf_link;
     };
 
+    Alphabet alphabet;
     std::shared_ptr<Node> root;
 
     void add_next_vertices(std::shared_ptr<Node> vertex, std::queue<std::shared_ptr<Node>>& output);
@@ -49,8 +102,9 @@ private:
     void add_pattern(const std::string_view& pattern, size_t pattern_index);
 };
 
-Trie::Trie(const std::vector<std::pair<std::string_view, size_t>>& subpatterns) {
-    root = std::make_shared<Node>(-1, false);
+Trie::Trie(const std::vector<std::pair<std::string_view, size_t>>& subpatterns)
+        : alphabet(subpatterns) {
+    root = std::make_shared<Node>(Alphabet::no_match, false, alphabet.size());
 
     for (size_t i = 0; i < subpatterns.size(); ++i){
         add_pattern(subpatterns[i].first, i);
@@ -62,13 +116,14 @@ Trie::Trie(const std::vector<std::pair<std::string_view, size_t>>& subpatterns)
 void Trie::add_pattern(const std::string_view& pattern, size_t pattern_index) {
     std::shared_ptr<Node> current = root;
     for (auto c : pattern){
-        if (current->next_vertices[c - first_letter] != nullptr) {
-            current = current->next_vertices[c - first_letter];
+        uint16_t code = alphabet[c];
+        if (current->next_vertices[code] != nullptr) {
+            current = current->next_vertices[code];
         }
         else {
-            current->next_vertices[c - first_letter] =
-                    std::make_shared<Node>(c, false, current);
-            current = current->next_vertices[c - first_letter];
+            current->next_vertices[code] =
+                    std::make_shared<Node>(code, false, alphabet.size(), current);
+            current = current->next_vertices[code];
         }
     }
     current->is_terminate = true;
@@ -84,7 +139,7 @@ void Trie::add_next_vertices(std::shared_ptr<Node> vertex, std::queue<std::share
 void Trie::create_suf_ptr() {
     std::queue<std::shared_ptr<Node>> BFS_queue;
 
-    char step;
+    uint16_t step;
 
     root->suf_link = root;
     for (auto v : root->next_vertices) {
@@ -101,8 +156,8 @@ void Trie::create_suf_ptr() {
         BFS_queue.pop();
 
         while (true) { //построение суффиксных ссылок bfs
-            if (current_suf->suf_link.lock()->next_vertices[step - first_letter] != nullptr) {
-                current->suf_link = current_suf->suf_link.lock()->next_vertices[step - first_letter];
+            if (current_suf->suf_link.lock()->next_vertices[step] != nullptr) {
+                current->suf_link = current_suf->suf_link.lock()->next_vertices[step];
                 break;
             }
             else if (current_suf->suf_link.lock() == root) {
@@ -155,11 +210,13 @@ std::vector<std::pair<std::string_view, size_t>> pattern_split(std::string_view
 class Aho_Korasick {
 public:
     Aho_Korasick(const Trie& trie)
-    : current_vertex(trie.root)
+    : alphabet(trie.alphabet)
+    , current_vertex(trie.root)
     , root(trie.root) { }
     std::vector<uint32_t> next_state(const char c);
 
 private:
+    const Alphabet& alphabet;
     std::shared_ptr<Trie::Node> current_vertex;
     std::shared_ptr<Trie::Node> root;
 };
@@ -167,10 +224,16 @@ private:
 std::vector<uint32_t> Aho_Korasick::next_state(const char c) {
     std::shared_ptr<Trie::Node> short_suf;
     std::vector<uint32_t> result;
+    uint16_t code = alphabet[c];
+
+    if (code == Alphabet::no_match) { //no pattern contains c, so automaton restarts
+        current_vertex = root;
+        return result;
+    }
 
     while (true) {
-        if (current_vertex->next_vertices[c - first_letter] != nullptr) {
-            current_vertex = current_vertex->next_vertices[c - first_letter];
+        if (current_vertex->next_vertices[code] != nullptr) {
+            current_vertex = current_vertex->next_vertices[code];
 
             if (current_vertex->is_terminate) {
                 for (auto v : current_vertex->index_of_pattern) {
@@ -190,14 +253,14 @@ std::vector<uint32_t> Aho_Korasick::next_state(const char c) {
         } else if (current_vertex != root) {
             while (current_vertex != root) {
                 current_vertex = current_vertex->suf_link.lock();
-                if (current_vertex->next_vertices[c - first_letter] != nullptr) break;
+                if (current_vertex->next_vertices[code] != nullptr) break;
             }
         } else break;
     }
     return result;
 }
 
-std::vector<uint32_t> find_patterns_occurances(std::string_view pattern, const std::string& text) {
+std::vector<uint32_t> find_patterns_occurances_by_automaton(std::string_view pattern, const std::string& text) {
     std::vector<std::pair<std::string_view, size_t>> subpatterns = pattern_split(pattern, '?');
     std::vector<uint16_t> count_occurances(text.length(), 0);
     std::vector<uint32_t> answer;
@@ -219,12 +282,616 @@ std::vector<uint32_t> find_patterns_occurances(std::string_view pattern, const s
     return answer;
 }
 
-int main() {
-    std::string text;
+//byte pair of pattern which is expected to be the rarest in text, offset is position of first byte in pattern
+struct Rare_pair {
+    char first;
+    char second;
+    size_t offset;
+    bool is_pair; //false if no fragment is longer than one symbol, then only first is used
+    double frequency; //expected amount of occurances per text byte
+};
+
+Rare_pair choose_rare_pair(const std::vector<std::pair<std::string_view, size_t>>& subpatterns,
+        const std::string& text) {
+    constexpr size_t sample_size = 1 << 16;
+    size_t sample = std::min(text.length(), sample_size);
+    std::array<double, bytes_amount> frequency;
+    frequency.fill(1.); //smoothing, bytes unseen in sample are still possible
+    for (size_t i = 0; i < sample; ++i) {
+        frequency[static_cast<unsigned char>(text[i])] += 1.;
+    }
+    for (auto& f : frequency) f /= sample + bytes_amount;
+
+    Rare_pair result = {0, 0, 0, false, 2.};
+    for (auto& subpattern : subpatterns) {
+        std::string_view fragment = subpattern.first;
+        size_t start = subpattern.second + 1 - fragment.length();
+        for (size_t k = 0; k < fragment.length(); ++k) {
+            double first_frequency = frequency[static_cast<unsigned char>(fragment[k])];
+            bool has_second = (k + 1 < fragment.length());
+            double pair_frequency = first_frequency *
+                    (has_second ? frequency[static_cast<unsigned char>(fragment[k + 1])] : 1.);
+            if ((has_second && !result.is_pair) || (has_second == result.is_pair && pair_frequency < result.frequency)) {
+                result = {fragment[k], (has_second ? fragment[k + 1] : '\0'), start + k, has_second, pair_frequency};
+            }
+        }
+    }
+    return result;
+}
+
+//calls on_candidate(i) for every i < windows with text[i] == first and, if is_pair, text[i + 1] == second;
+//text must be readable up to text[windows] if is_pair
+template <class Callback>
+void scan_for_rare_pair(const char* text, size_t windows, const Rare_pair& pair, Callback&& on_candidate) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256i first_32 = _mm256_set1_epi8(pair.first);
+    const __m256i second_32 = _mm256_set1_epi8(pair.second);
+    for (; i + 32 <= windows; i += 32) {
+        uint32_t mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i)), first_32));
+        if (mask != 0 && pair.is_pair) {
+            mask &= _mm256_movemask_epi8(_mm256_cmpeq_epi8(
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i + 1)), second_32));
+        }
+        for (; mask != 0; mask &= mask - 1) {
+            on_candidate(i + __builtin_ctz(mask));
+        }
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i first_16 = _mm_set1_epi8(pair.first);
+    const __m128i second_16 = _mm_set1_epi8(pair.second);
+    for (; i + 16 <= windows; i += 16) {
+        uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i)), first_16));
+        if (mask != 0 && pair.is_pair) {
+            mask &= _mm_movemask_epi8(_mm_cmpeq_epi8(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + 1)), second_16));
+        }
+        for (; mask != 0; mask &= mask - 1) {
+            on_candidate(i + __builtin_ctz(mask));
+        }
+    }
+#endif
+    for (; i < windows; ++i) {
+        if (text[i] == pair.first && (!pair.is_pair || text[i + 1] == pair.second))
+            on_candidate(i);
+    }
+}
+
+//rare pair of pattern is searched with vector compares and only windows around its occurances are compared
+//with pattern directly; if the pair is frequent in text, automaton is used instead
+std::vector<uint32_t> find_patterns_occurances(std::string_view pattern, const std::string& text) {
+    constexpr double max_candidates_frequency = 1. / 16;
+    std::vector<std::pair<std::string_view, size_t>> subpatterns = pattern_split(pattern, '?');
+    std::vector<uint32_t> answer;
+    if (pattern.empty() || text.length() < pattern.length()) return answer; //empty pattern has no occurances
+
+    size_t windows = text.length() - pattern.length() + 1;
+    if (subpatterns.empty()) { //pattern consists of '?' only
+        for (size_t i = 0; i < windows; ++i) answer.push_back(i);
+        return answer;
+    }
+
+    Rare_pair pair = choose_rare_pair(subpatterns, text);
+    if (pair.frequency > max_candidates_frequency) {
+        return find_patterns_occurances_by_automaton(pattern, text);
+    }
+
+    scan_for_rare_pair(text.data() + pair.offset, windows, pair, [&](size_t start) {
+        for (auto& subpattern : subpatterns) {
+            size_t fragment_start = start + subpattern.second + 1 - subpattern.first.length();
+            if (std::memcmp(text.data() + fragment_start, subpattern.first.data(), subpattern.first.length()) != 0)
+                return;
+        }
+        answer.push_back(start);
+    });
+    return answer;
+}
+
+//Aho-Korasick automaton compiled from Trie into one flat buffer of uint32_t words:
+//header, byte codes, full transition table, output links, fragment indices and fragment offsets.
+//Buffer is position independent, so it is saved as is and loaded by mmap without any allocation per node;
+//all processes which map the same file share its read-only pages
+class Compiled_automaton {
+public:
+    Compiled_automaton(std::string_view pattern, const char separator); //pattern is not empty
+    Compiled_automaton(const Compiled_automaton&) = delete;
+    Compiled_automaton& operator=(const Compiled_automaton&) = delete;
+    Compiled_automaton(Compiled_automaton&& other) noexcept;
+    ~Compiled_automaton();
+
+    static Compiled_automaton load(const std::string& path);
+    void save(const std::string& path) const;
+
+    std::vector<uint32_t> find_patterns_occurances(const std::string& text) const;
+
+private:
+    static constexpr uint32_t magic = 0x4b434841; //"AHCK"
+    static constexpr uint32_t version = 1;
+    static constexpr uint32_t none = UINT32_MAX;
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t nodes_amount;
+        uint32_t alphabet_size;
+        uint32_t outputs_amount;
+        uint32_t fragments_amount;
+        uint32_t pattern_length;
+    };
+    static constexpr size_t header_words = sizeof(Header) / sizeof(uint32_t);
+
+    std::vector<uint32_t> buffer; //empty if automaton is mapped from file
+    void* mapping = nullptr;
+    size_t mapping_size = 0;
+
+    Header header;
+    const uint32_t* codes; //code of every byte, bytes_amount words
+    const uint32_t* transitions; //transitions[node * alphabet_size + code]
+    const uint32_t* first_output; //node itself if terminate, else nearest terminate node by suffix links or none
+    const uint32_t* next_output; //next terminate node by suffix links or none
+    const uint32_t* output_begin; //fragments of node v are outputs[output_begin[v], output_begin[v + 1])
+    const uint32_t* outputs;
+    const uint32_t* fragment_ends; //position of the last symbol of fragment in pattern
+
+    Compiled_automaton() = default;
+    static size_t words_amount(const Header& header);
+    void attach(const uint32_t* data, size_t words);
+    void validate() const;
+};
+
+Compiled_automaton::Compiled_automaton(std::string_view pattern, const char separator) {
+    if (pattern.empty()) throw std::runtime_error("pattern is empty");
+    std::vector<std::pair<std::string_view, size_t>> subpatterns = pattern_split(pattern, separator);
+    Trie trie(subpatterns);
+
+    std::vector<std::shared_ptr<Trie::Node>> nodes; //bfs order, so suffix link leads to already numbered node
+    std::unordered_map<const Trie::Node*, uint32_t> index;
+    nodes.push_back(trie.root);
+    index[trie.root.get()] = 0;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        for (auto& v : nodes[i]->next_vertices) {
+            if (v != nullptr) {
+                index[v.get()] = nodes.size();
+                nodes.push_back(v);
+            }
+        }
+    }
+
+    Header head = {magic, version, static_cast<uint32_t>(nodes.size()), static_cast<uint32_t>(trie.alphabet.size()),
+                   0, static_cast<uint32_t>(subpatterns.size()), static_cast<uint32_t>(pattern.length())};
+    for (auto& v : nodes) head.outputs_amount += v->index_of_pattern.size();
+
+    std::vector<uint32_t> data(words_amount(head), 0);
+    std::memcpy(data.data(), &head, sizeof(Header));
+    uint32_t* current = data.data() + header_words;
+    uint32_t* codes_ = current;
+    uint32_t* transitions_ = (current += bytes_amount);
+    uint32_t* first_output_ = (current += static_cast<size_t>(head.nodes_amount) * head.alphabet_size);
+    uint32_t* next_output_ = (current += head.nodes_amount);
+    uint32_t* output_begin_ = (current += head.nodes_amount);
+    uint32_t* outputs_ = (current += head.nodes_amount + 1);
+    uint32_t* fragment_ends_ = (current += head.outputs_amount);
+
+    for (size_t c = 0; c < bytes_amount; ++c) {
+        codes_[c] = trie.alphabet[static_cast<char>(c)];
+    }
+    for (uint32_t v = 0; v < nodes.size(); ++v) {
+        uint32_t* row = transitions_ + static_cast<size_t>(v) * head.alphabet_size;
+        uint32_t suf = index[nodes[v]->suf_link.lock().get()];
+        for (uint32_t code = 1; code < head.alphabet_size; ++code) {
+            if (nodes[v]->next_vertices[code] != nullptr)
+                row[code] = index[nodes[v]->next_vertices[code].get()];
+            else
+                row[code] = (v == 0 ? 0 : transitions_[static_cast<size_t>(suf) * head.alphabet_size + code]);
+        }
+
+        std::shared_ptr<Trie::Node> short_suf = nodes[v]->short_suf_link.lock();
+        next_output_[v] = (short_suf ? index[short_suf.get()] : none);
+        first_output_[v] = (nodes[v]->is_terminate ? v : next_output_[v]);
+
+        output_begin_[v + 1] = output_begin_[v];
+        for (auto f : nodes[v]->index_of_pattern) {
+            outputs_[output_begin_[v + 1]++] = f;
+        }
+    }
+    for (size_t f = 0; f < subpatterns.size(); ++f) {
+        fragment_ends_[f] = subpatterns[f].second;
+    }
+
+    buffer.swap(data);
+    attach(buffer.data(), buffer.size());
+}
+
+Compiled_automaton::Compiled_automaton(Compiled_automaton&& other) noexcept
+        : buffer(std::move(other.buffer))
+        , mapping(other.mapping)
+        , mapping_size(other.mapping_size) {
+    other.mapping = nullptr;
+    attach(mapping ? static_cast<const uint32_t*>(mapping) : buffer.data(),
+           mapping ? mapping_size / sizeof(uint32_t) : buffer.size());
+}
+
+Compiled_automaton::~Compiled_automaton() {
+    if (mapping) munmap(mapping, mapping_size);
+}
+
+size_t Compiled_automaton::words_amount(const Header& header) {
+    return header_words + bytes_amount
+           + static_cast<size_t>(header.nodes_amount) * header.alphabet_size
+           + 3 * static_cast<size_t>(header.nodes_amount) + 1
+           + header.outputs_amount + header.fragments_amount;
+}
+
+void Compiled_automaton::attach(const uint32_t* data, size_t words) {
+    if (words < header_words) throw std::runtime_error("automaton file is truncated");
+    std::memcpy(&header, data, sizeof(Header));
+    if (header.magic != magic || header.version != version)
+        throw std::runtime_error("file is not a compiled automaton of this version");
+    if (words != words_amount(header) || header.nodes_amount == 0 || header.alphabet_size == 0)
+        throw std::runtime_error("automaton file is corrupted");
+
+    codes = data + header_words;
+    transitions = codes + bytes_amount;
+    first_output = transitions + static_cast<size_t>(header.nodes_amount) * header.alphabet_size;
+    next_output = first_output + header.nodes_amount;
+    output_begin = next_output + header.nodes_amount;
+    outputs = output_begin + header.nodes_amount + 1;
+    fragment_ends = outputs + header.outputs_amount;
+}
+
+//every index read from a file is checked once, so search never reads out of the buffer: codes and transitions
+//are inside the table, outputs are ranges of fragments, output links go to nodes with smaller bfs numbers,
+//so every chain of them ends, and pattern is not empty, so there are at most n windows of text
+void Compiled_automaton::validate() const {
+    auto check = [](bool is_valid) {
+        if (!is_valid) throw std::runtime_error("automaton file is corrupted");
+    };
+    check(header.pattern_length > 0);
+    for (size_t c = 0; c < bytes_amount; ++c) check(codes[c] < header.alphabet_size);
+    for (size_t k = 0; k < static_cast<size_t>(header.nodes_amount) * header.alphabet_size; ++k) {
+        check(transitions[k] < header.nodes_amount);
+    }
+    check(output_begin[0] == 0 && output_begin[header.nodes_amount] == header.outputs_amount);
+    for (uint32_t v = 0; v < header.nodes_amount; ++v) {
+        check(next_output[v] == none || next_output[v] < v);
+        check(first_output[v] == v || first_output[v] == next_output[v]);
+        check(output_begin[v] <= output_begin[v + 1]);
+    }
+    for (uint32_t k = 0; k < header.outputs_amount; ++k) check(outputs[k] < header.fragments_amount);
+    for (uint32_t f = 0; f < header.fragments_amount; ++f) check(fragment_ends[f] < header.pattern_length);
+}
+
+Compiled_automaton Compiled_automaton::load(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("can not open " + path);
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0 || info.st_size % sizeof(uint32_t) != 0) {
+        close(fd);
+        throw std::runtime_error("automaton file is corrupted");
+    }
+    void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) throw std::runtime_error("can not map " + path);
+
+    Compiled_automaton result;
+    result.mapping = mapped;
+    result.mapping_size = info.st_size;
+    result.attach(static_cast<const uint32_t*>(mapped), info.st_size / sizeof(uint32_t));
+    result.validate();
+    return result;
+}
+
+void Compiled_automaton::save(const std::string& path) const {
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) throw std::runtime_error("can not create " + path);
+    const char* data = reinterpret_cast<const char*>(codes - header_words);
+    size_t left = words_amount(header) * sizeof(uint32_t);
+    while (left > 0) {
+        ssize_t written = write(fd, data, left);
+        if (written <= 0) {
+            close(fd);
+            throw std::runtime_error("can not write " + path);
+        }
+        data += written;
+        left -= written;
+    }
+    close(fd);
+}
+
+std::vector<uint32_t> Compiled_automaton::find_patterns_occurances(const std::string& text) const {
+    std::vector<uint16_t> count_occurances(text.length(), 0);
+    std::vector<uint32_t> answer;
+    uint32_t state = 0;
+
+    for (size_t i = 0; i < text.length(); ++i) {
+        uint32_t code = codes[static_cast<unsigned char>(text[i])];
+        state = transitions[static_cast<size_t>(state) * header.alphabet_size + code];
+        for (uint32_t v = first_output[state]; v != none; v = next_output[v]) {
+            for (uint32_t k = output_begin[v]; k < output_begin[v + 1]; ++k) {
+                if (i >= fragment_ends[outputs[k]])
+                    ++count_occurances[i - fragment_ends[outputs[k]]];
+            }
+        }
+    }
+    size_t text_iterate_size = (text.length() + 1 > header.pattern_length ?
+                                text.length() - header.pattern_length + 1 : 0);
+    for (size_t i = 0; i < text_iterate_size; ++i) {
+        if (count_occurances[i] == header.fragments_amount)
+            answer.push_back(i);
+    }
+    return answer;
+}
+
+//answers lce(first, second) -- length of the longest common prefix of suffixes of str beginning in first and second
+//with suffix array, lcp array and block sparse table over lcp, so query is O(block_size)
+class Longest_common_extension {
+public:
+    explicit Longest_common_extension(const std::vector<uint32_t>& _str);
+    uint32_t lce(uint32_t first, uint32_t second) const;
+
+private:
+    static constexpr uint32_t block_size = 32;
+
+    std::vector<uint32_t> array; //suffix array of str
+    std::vector<uint32_t> position_array; //if array[i] = k, then position_array[k] = i
+    std::vector<uint32_t> lcp_array; //lcp[i] = lcp of suffixes begins in array[i] and array[i + 1]
+    std::vector<std::vector<uint32_t>> block_min; //block_min[j][b] = min of lcp on blocks [b, b + 2^j)
+
+    void init_suf_array(const std::vector<uint32_t>& str, uint32_t alphabet);
+    void init_lcp_array(const std::vector<uint32_t>& str);
+    void init_block_min();
+    uint32_t range_min(uint32_t left, uint32_t right) const; //min of lcp on [left, right)
+};
+
+Longest_common_extension::Longest_common_extension(const std::vector<uint32_t>& _str) {
+    //symbol 0 is reserved for the cyclic sentinel
+    std::vector<uint32_t> str(_str);
+    str.push_back(0);
+    init_suf_array(str, *std::max_element(str.begin(), str.end()) + 1);
+
+    position_array.assign(str.size(), 0);
+    for (uint32_t i = 0; i < str.size(); ++i) {
+        position_array[array[i]] = i;
+    }
+
+    init_lcp_array(str);
+    init_block_min();
+}
+
+void Longest_common_extension::init_suf_array(const std::vector<uint32_t>& str, uint32_t alphabet) {
+    const uint32_t n = str.size();
+    std::vector<uint32_t> eq_classes(str);
+    std::vector<uint32_t> new_classes(n);
+    std::vector<uint32_t> buffer(n);
+    std::vector<uint32_t> counter(std::max(alphabet, n) + 1, 0);
+    array.assign(n, 0);
+
+    for (uint32_t i = 0; i < n; ++i) ++counter[str[i] + 1]; //sort one symbol
+    for (uint32_t i = 1; i <= alphabet; ++i) counter[i] += counter[i - 1];
+    for (uint32_t i = 0; i < n; ++i) array[counter[str[i]]++] = i;
+    uint32_t classes_amount = alphabet;
+
+    for (uint32_t step = 1; step < n; step <<= 1) {
+        for (uint32_t i = 0; i < n; ++i) { //sorted by second half
+            buffer[i] = (array[i] + n - step) % n;
+        }
+        std::fill(counter.begin(), counter.begin() + classes_amount + 1, 0);
+        for (uint32_t i = 0; i < n; ++i) ++counter[eq_classes[buffer[i]] + 1];
+        for (uint32_t i = 1; i <= classes_amount; ++i) counter[i] += counter[i - 1];
+        for (uint32_t i = 0; i < n; ++i) array[counter[eq_classes[buffer[i]]]++] = buffer[i];
+
+        new_classes[array[0]] = 0;
+        classes_amount = 1;
+        for (uint32_t i = 1; i < n; ++i) {
+            if (eq_classes[array[i]] != eq_classes[array[i - 1]] ||
+                eq_classes[(array[i] + step) % n] != eq_classes[(array[i - 1] + step) % n])
+                ++classes_amount;
+            new_classes[array[i]] = classes_amount - 1;
+        }
+        eq_classes.swap(new_classes);
+        if (classes_amount == n) break; //all suffixes are different already
+    }
+}
+
+void Longest_common_extension::init_lcp_array(const std::vector<uint32_t>& str) { //Kasai algorithm
+    const uint32_t n = str.size();
+    lcp_array.assign(n, 0);
+    uint32_t k = 0;
+    for (uint32_t i = 0; i < n; ++i) {
+        if (position_array[i] == n - 1) {
+            k = 0;
+            continue;
+        }
+        uint32_t j = array[position_array[i] + 1];
+        while (i + k < n && j + k < n && str[i + k] == str[j + k]) ++k;
+        lcp_array[position_array[i]] = k;
+        if (k > 0) --k;
+    }
+}
+
+void Longest_common_extension::init_block_min() {
+    uint32_t blocks = (lcp_array.size() + block_size - 1) / block_size;
+    block_min.emplace_back(blocks, UINT32_MAX);
+    for (uint32_t i = 0; i < lcp_array.size(); ++i) {
+        block_min[0][i / block_size] = std::min(block_min[0][i / block_size], lcp_array[i]);
+    }
+    for (uint32_t j = 1; (1u << j) <= blocks; ++j) {
+        const std::vector<uint32_t>& prev = block_min[j - 1];
+        std::vector<uint32_t> level(blocks - (1u << j) + 1);
+        for (uint32_t b = 0; b < level.size(); ++b) {
+            level[b] = std::min(prev[b], prev[b + (1u << (j - 1))]);
+        }
+        block_min.push_back(std::move(level));
+    }
+}
+
+uint32_t Longest_common_extension::range_min(uint32_t left, uint32_t right) const {
+    uint32_t result = UINT32_MAX;
+    uint32_t left_block = (left + block_size - 1) / block_size;
+    uint32_t right_block = right / block_size;
+    if (left_block >= right_block) { //range is inside one or two neighbour blocks
+        for (uint32_t i = left; i < right; ++i) result = std::min(result, lcp_array[i]);
+        return result;
+    }
+    for (uint32_t i = left; i < left_block * block_size; ++i) result = std::min(result, lcp_array[i]);
+    for (uint32_t i = right_block * block_size; i < right; ++i) result = std::min(result, lcp_array[i]);
+    uint32_t level = 31 - __builtin_clz(right_block - left_block);
+    result = std::min(result, block_min[level][left_block]);
+    return std::min(result, block_min[level][right_block - (1u << level)]);
+}
+
+uint32_t Longest_common_extension::lce(uint32_t first, uint32_t second) const {
+    if (first == second) return array.size() - 1 - first;
+    uint32_t left = position_array[first];
+    uint32_t right = position_array[second];
+    if (left > right) std::swap(left, right);
+    return range_min(left, right);
+}
+
+//positions where pattern matches text with at most max_mismatches mismatched ordinary symbols, '?' matches anything
+//kangaroo method: every alignment costs O(max_mismatches + number of '?' blocks) lce queries
+std::vector<uint32_t> find_patterns_occurances_with_mismatches(std::string_view pattern, const std::string& text,
+        size_t max_mismatches) {
+    constexpr char separator = '?';
+    std::vector<uint32_t> answer;
+    if (pattern.empty() || text.length() < pattern.length()) return answer;
+
+    //pattern + unique separator + text, bytes are shifted to keep 0 and 1 free
+    std::vector<uint32_t> str;
+    str.reserve(pattern.length() + text.length() + 1);
+    for (auto c : pattern) str.push_back(static_cast<unsigned char>(c) + 2);
+    str.push_back(1);
+    for (auto c : text) str.push_back(static_cast<unsigned char>(c) + 2);
+    Longest_common_extension lce_index(str);
+
+    std::vector<uint32_t> after_wildcards(pattern.length() + 1, pattern.length()); //first position after run of '?'
+    for (size_t p = pattern.length(); p-- > 0;) {
+        after_wildcards[p] = (pattern[p] == separator ? after_wildcards[p + 1] : p);
+    }
+
+    const uint32_t m = pattern.length();
+    const uint32_t text_start = m + 1;
+    for (uint32_t i = 0; i + m <= text.length(); ++i) {
+        size_t mismatches = 0;
+        uint32_t p = after_wildcards[0];
+        while (p < m) {
+            p += lce_index.lce(p, text_start + i + p);
+            if (p >= m) break;
+            if (pattern[p] != separator && ++mismatches > max_mismatches) break;
+            p = after_wildcards[p + 1];
+        }
+        if (mismatches <= max_mismatches)
+            answer.push_back(i);
+    }
+    return answer;
+}
+
+std::string random_string(size_t length, char first, size_t letters, std::mt19937& generator) {
+    std::uniform_int_distribution<int> letter(0, letters - 1);
+    std::string result(length, first);
+    for (auto& c : result) c = static_cast<char>(first + letter(generator));
+    return result;
+}
+
+void benchmark_mismatches() {
+    std::mt19937 generator(2020);
+    std::string text = random_string(2000000, first_letter, 4, generator);
+    std::string pattern = text.substr(1000, 1000);
+    for (size_t p = 0; p < pattern.length(); p += 97) pattern[p] = '?';
+
+    for (size_t k : {0, 1, 2, 4, 8, 16, 32}) {
+        auto start = std::chrono::steady_clock::now();
+        size_t found = find_patterns_occurances_with_mismatches(pattern, text, k).size();
+        std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+        std::cout << "k = " << k << ": " << found << " occurances, " << seconds.count() << " s\n";
+    }
+}
+
+void benchmark_prefilter() {
+    std::mt19937 generator(2020);
+    std::string sparse_text = random_string(1 << 26, first_letter, 26, generator);
+    std::string sparse_pattern = "qj?zx??kw?vq";
+    for (size_t i = 0; i < 1000; ++i) { //plant occurances
+        size_t position = generator() % (sparse_text.length() - sparse_pattern.length());
+        for (size_t k = 0; k < sparse_pattern.length(); ++k) {
+            if (sparse_pattern[k] != '?') sparse_text[position + k] = sparse_pattern[k];
+        }
+    }
+    std::string dense_text = random_string(1 << 24, first_letter, 2, generator);
+    std::string dense_pattern = "ab?ab";
+
+    for (auto& test : {std::make_pair(&sparse_pattern, &sparse_text), std::make_pair(&dense_pattern, &dense_text)}) {
+        for (bool use_prefilter : {false, true}) {
+            auto start = std::chrono::steady_clock::now();
+            size_t found = (use_prefilter ? find_patterns_occurances(*test.first, *test.second)
+                                          : find_patterns_occurances_by_automaton(*test.first, *test.second)).size();
+            std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+            std::cout << (test.first == &sparse_pattern ? "sparse" : "dense") << " hits, "
+                      << (use_prefilter ? "prefilter: " : "automaton: ") << found << " occurances, "
+                      << test.second->length() / seconds.count() / 1e9 << " GB/s\n";
+        }
+    }
+}
+
+//pattern is the first line of input without the line break
+std::string read_pattern(std::istream& input) {
     std::string pattern;
-    std::cin >> pattern;
-    std::cin >> text;
-    std::vector<uint32_t> result = find_patterns_occurances(std::string_view(pattern), text);
+    std::getline(input, pattern);
+    return pattern;
+}
+
+//text is the rest of input byte by byte, so it may contain spaces and any other bytes;
+//only the final line break of input is not a part of it
+std::string read_text(std::istream& input) {
+    std::string text((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    if (!text.empty() && text.back() == '\n') text.pop_back();
+    return text;
+}
+
+//usage: solutionC [--mismatches k | --bench-mismatches | --bench-prefilter], pattern and text are read from stdin
+//solutionC --save file reads only pattern and saves compiled automaton,
+//solutionC --load file reads only text and searches with automaton from file
+int main(int argc, char* argv[]) {
+    std::ios::sync_with_stdio(false);
+    std::string mode = (argc > 1 ? argv[1] : "");
+    if (mode == "--bench-mismatches") {
+        benchmark_mismatches();
+        return 0;
+    }
+    if (mode == "--bench-prefilter") {
+        benchmark_prefilter();
+        return 0;
+    }
+    if ((mode == "--save" || mode == "--load") && argc > 2) {
+        std::string input = (mode == "--save" ? read_pattern(std::cin) : read_text(std::cin));
+        try {
+            if (mode == "--save") {
+                Compiled_automaton(input, '?').save(argv[2]);
+                return 0;
+            }
+            for (auto v : Compiled_automaton::load(argv[2]).find_patterns_occurances(input)) {
+                std::cout << v << ' ';
+            }
+        }
+        catch (const std::exception& error) {
+            std::cerr << error.what() << '\n';
+            return 1;
+        }
+        return 0;
+    }
+
+    std::string pattern = read_pattern(std::cin);
+    std::string text = read_text(std::cin);
+    std::vector<uint32_t> result;
+    if (mode == "--mismatches" && argc > 2) {
+        result = find_patterns_occurances_with_mismatches(pattern, text, std::stoul(argv[2]));
+    }
+    else {
+        result = find_patterns_occurances(std::string_view(pattern), text);
+    }
     for (auto v : result) {
         std::cout << v << ' ';
     }